@@ -1,14 +1,22 @@
 
 #include "JniObject.hpp"
 #include <algorithm>
+#include <cstring>
 #include <pthread.h>
 
 JavaVM* Jni::_java = nullptr;
-JNIEnv* Jni::_env = nullptr;
 int Jni::_thread = 0;
+thread_local JNIEnv* Jni::_threadEnv = nullptr;
  
-Jni::Jni()
+Jni::Jni():
+_classes(nullptr),
+_classPaths(nullptr), _systemClass(nullptr), _identityHashCode(nullptr),
+_methodHits(0), _methodMisses(0)
 {
+    _classSnapshots.emplace_back(new ClassMap());
+    _classes = _classSnapshots.back().get();
+    _classPathSnapshots.emplace_back(new ClassPathMap());
+    _classPaths = _classPathSnapshots.back().get();
 }
  
 Jni::Jni(const Jni& other)
@@ -18,14 +26,41 @@ Jni::Jni(const Jni& other)
  
 Jni::~Jni()
 {
-    if(!_classes.empty())
+    _workers.reset();
+    const ClassMap* classes = _classes.load(std::memory_order_acquire);
+    const ClassPathMap* classPaths = _classPaths.load(std::memory_order_acquire);
+    if(!classes->empty() || !classPaths->empty() || !_strings.empty() || !_singletons.empty())
     {
         JNIEnv* env = getEnvironment();
         if(env)
         {
-            for(ClassMap::const_iterator itr = _classes.begin(); itr != _classes.end(); ++itr)
+            for(ClassMap::const_iterator itr = classes->begin(); itr != classes->end(); ++itr)
             {
-                env->DeleteGlobalRef(itr->second);
+                for(const ClassEntry& entry : itr->second)
+                {
+                    if(entry.classId)
+                    {
+                        env->DeleteGlobalRef(entry.classId);
+                    }
+                }
+            }
+            for(ClassPathMap::const_iterator itr = classPaths->begin(); itr != classPaths->end(); ++itr)
+            {
+                for(const ClassEntry& entry : itr->second)
+                {
+                    env->DeleteGlobalRef(entry.classId);
+                }
+            }
+            for(const std::pair<const std::string, jstring>& str : _strings)
+            {
+                env->DeleteGlobalRef(str.second);
+            }
+            for(const std::pair<const std::string, SingletonEntry>& singleton : _singletons)
+            {
+                if(singleton.second.instance)
+                {
+                    env->DeleteGlobalRef(singleton.second.instance);
+                }
             }
         }
     }
@@ -56,31 +91,138 @@ jint Jni::onLoad(JavaVM* java)
     } 
     _java = java;
     pthread_key_create(&_thread, Jni::detachCurrentThread);
+    // used by every class path lookup
+    _systemClass = getClass("java/lang/System");
+    _identityHashCode = getMethodId(_systemClass, "identityHashCode", "(Ljava/lang/Object;)I", true);
+    env->ExceptionClear();
     return JNI_VERSION_1_4;
 }
  
 JNIEnv* Jni::getEnvironment()
 {
+    JNIEnv* env = _threadEnv;
+    if(env)
+    {
+        return env;
+    }
     if(_java == nullptr)
     {
         throw JniException("Jni::onLoad not called.");
     }
-    JNIEnv* env = static_cast<JNIEnv*>(pthread_getspecific(_thread));
-    if((env ) == NULL)
+    if(_java->GetEnv((void**)&env, JNI_VERSION_1_4) != JNI_OK)
     {
-        _java->GetEnv((void**)&_env, JNI_VERSION_1_4);
+        // only threads attached here are detached on exit
         _java->AttachCurrentThread(&env, nullptr);
         pthread_setspecific(_thread, env);
     }
+    _threadEnv = env;
     return env;
 }
  
+JNIEnv* Jni::attachThread(const std::string& name, bool daemon)
+{
+    if(_java == nullptr)
+    {
+        throw JniException("Jni::onLoad not called.");
+    }
+    JNIEnv* env = nullptr;
+    JavaVMAttachArgs args;
+    args.version = JNI_VERSION_1_4;
+    args.name = name.c_str();
+    args.group = nullptr;
+    jint result = daemon ? _java->AttachCurrentThreadAsDaemon(&env, &args) : _java->AttachCurrentThread(&env, &args);
+    if(result != JNI_OK)
+    {
+        throw JniException("could not attach thread "+name);
+    }
+    _threadEnv = env;
+    return env;
+}
+
+void Jni::detachThread()
+{
+    if(_java && _threadEnv)
+    {
+        _java->DetachCurrentThread();
+        _threadEnv = nullptr;
+    }
+}
+
+JniWorkerPool& Jni::getWorkers()
+{
+    std::lock_guard<std::mutex> lock(_workersMutex);
+    if(!_workers)
+    {
+        size_t count = std::max(1u, std::thread::hardware_concurrency());
+        _workers.reset(new JniWorkerPool(count));
+    }
+    return *_workers;
+}
+
+const Jni::ClassEntry* Jni::findCachedClass(const ClassMap& classes, const std::string& classPath, size_t classHash)
+{
+    ClassMap::const_iterator itr = classes.find(classHash);
+    if(itr == classes.end())
+    {
+        return nullptr;
+    }
+    for(const ClassEntry& entry : itr->second)
+    {
+        if(entry.classPath == classPath)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+jclass Jni::addClass(JNIEnv* env, const std::string& classPath, size_t classHash, jclass classId)
+{
+    std::lock_guard<std::mutex> lock(_classesMutex);
+    const ClassMap* classes = _classes.load(std::memory_order_relaxed);
+    const ClassEntry* cached = findCachedClass(*classes, classPath, classHash);
+    if(cached && (cached->classId || !classId))
+    {
+        return cached->classId;
+    }
+    ClassMap* updated = new ClassMap(*classes);
+    std::vector<ClassEntry>& entries = (*updated)[classHash];
+    ClassEntry entry = {classPath, classId ? (jclass)env->NewGlobalRef(classId) : nullptr};
+    std::vector<ClassEntry>::iterator itr = entries.begin();
+    while(itr != entries.end() && itr->classPath != classPath)
+    {
+        ++itr;
+    }
+    if(itr != entries.end())
+    {
+        // replaces a miss
+        *itr = entry;
+    }
+    else
+    {
+        entries.push_back(entry);
+    }
+    _classSnapshots.emplace_back(updated);
+    _classes.store(updated, std::memory_order_release);
+    return entry.classId;
+}
+
+size_t Jni::getClassHash(const std::string& classPath)
+{
+    return std::hash<std::string>()(classPath);
+}
+
 jclass Jni::getClass(const std::string& classPath, bool cache)
 {
-    ClassMap::const_iterator itr = _classes.find(classPath);
-    if(itr != _classes.end())
+    return getClass(classPath, getClassHash(classPath), cache);
+}
+
+jclass Jni::getClass(const std::string& classPath, size_t classHash, bool cache)
+{
+    const ClassEntry* cached = findCachedClass(*_classes.load(std::memory_order_acquire), classPath, classHash);
+    if(cached)
     {
-        return itr->second;
+        return cached->classId;
     }
     JNIEnv* env = getEnvironment();
     if(env)
@@ -90,8 +232,9 @@ jclass Jni::getClass(const std::string& classPath, bool cache)
         {
             if(cache)
             {
-                cls = (jclass)env->NewGlobalRef(cls);
-                _classes[classPath] = cls;
+                jclass local = cls;
+                cls = addClass(env, classPath, classHash, local);
+                env->DeleteLocalRef(local);
                 return cls;
             }
             else
@@ -102,194 +245,1510 @@ jclass Jni::getClass(const std::string& classPath, bool cache)
         else
         {
             env->ExceptionClear();
+            if(cache)
+            {
+                addClass(env, classPath, classHash, nullptr);
+            }
         }
     }
     return nullptr;
 }
 
-#pragma mark - JniObject
- 
-JniObject::JniObject(const std::string& classPath, jobject objId, jclass classId) :
-_instance(nullptr), _class(nullptr)
+jclass Jni::registerClass(const std::string& classPath, jclass classId)
 {
-    init(objId, classId, classPath);
+    size_t classHash = getClassHash(classPath);
+    const ClassEntry* cached = findCachedClass(*_classes.load(std::memory_order_acquire), classPath, classHash);
+    if(cached && cached->classId)
+    {
+        return cached->classId;
+    }
+    JNIEnv* env = getEnvironment();
+    if(!env || !classId)
+    {
+        return nullptr;
+    }
+    return addClass(env, classPath, classHash, classId);
 }
- 
-JniObject::JniObject(jclass classId, jobject objId) :
-_instance(nullptr), _class(nullptr)
+
+std::string Jni::getClassPath(jclass classId)
 {
-    init(objId, classId);
+    if(!classId)
+    {
+        return "";
+    }
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return "";
+    }
+    if(!_identityHashCode)
+    {
+        return "";
+    }
+    jvalue hashArgs[1];
+    hashArgs[0].l = classId;
+    jint hash = env->CallStaticIntMethodA(_systemClass, _identityHashCode, hashArgs);
+    if(env->ExceptionCheck())
+    {
+        env->ExceptionClear();
+        return "";
+    }
+    const ClassPathMap* classPaths = _classPaths.load(std::memory_order_acquire);
+    ClassPathMap::const_iterator bucket = classPaths->find(hash);
+    if(bucket != classPaths->end())
+    {
+        for(const ClassEntry& entry : bucket->second)
+        {
+            if(entry.classId == classId || env->IsSameObject(entry.classId, classId))
+            {
+                return entry.classPath;
+            }
+        }
+    }
+    jclass classClass = getClass("java/lang/Class");
+    jmethodID methodId = getMethodId(classClass, "getName", "()Ljava/lang/String;");
+    if(!methodId)
+    {
+        env->ExceptionClear();
+        return "";
+    }
+    jstring name = (jstring)env->CallObjectMethodA(classId, methodId, nullptr);
+    if(env->ExceptionCheck())
+    {
+        env->ExceptionClear();
+        return "";
+    }
+    std::string classPath;
+    JniObject::convertFromJavaString(env, name, classPath);
+    env->DeleteLocalRef(name);
+    std::replace(classPath.begin(), classPath.end(), '.', '/');
+
+    std::lock_guard<std::mutex> lock(_classPathsMutex);
+    classPaths = _classPaths.load(std::memory_order_relaxed);
+    bucket = classPaths->find(hash);
+    if(bucket != classPaths->end())
+    {
+        for(const ClassEntry& entry : bucket->second)
+        {
+            if(env->IsSameObject(entry.classId, classId))
+            {
+                return entry.classPath;
+            }
+        }
+    }
+    ClassPathMap* updated = new ClassPathMap(*classPaths);
+    ClassEntry entry = {classPath, (jclass)env->NewGlobalRef(classId)};
+    (*updated)[hash].push_back(entry);
+    _classPathSnapshots.emplace_back(updated);
+    _classPaths.store(updated, std::memory_order_release);
+    return classPath;
 }
- 
-JniObject::JniObject(jobject objId) :
-_instance(nullptr), _class(nullptr)
+
+template<typename Id>
+Jni::IdCache<Id>::IdCache()
 {
-    init(objId);
+    _classSnapshots.emplace_back(new ClassIds());
+    _classes = _classSnapshots.back().get();
 }
- 
-JniObject::JniObject(const JniObject& other) :
-_instance(nullptr), _class(nullptr)
+
+template<typename Id>
+bool Jni::IdCache<Id>::find(jclass classId, const std::string& name, const std::string& signature, Id& out) const
 {
-    init(other._instance, other._class, other._classPath);
+    const ClassIds* classes = _classes.load(std::memory_order_acquire);
+    typename ClassIds::const_iterator citr = classes->find(classId);
+    if(citr == classes->end())
+    {
+        return false;
+    }
+    typename Ids::const_iterator nitr = citr->second->find(name);
+    if(nitr == citr->second->end())
+    {
+        return false;
+    }
+    typename Ids::mapped_type::const_iterator sitr = nitr->second.find(signature);
+    if(sitr == nitr->second.end())
+    {
+        return false;
+    }
+    out = sitr->second;
+    return true;
 }
- 
-void JniObject::init(jobject objId, jclass classId, const std::string& classPath)
+
+template<typename Id>
+void Jni::IdCache<Id>::add(jclass classId, const std::string& name, const std::string& signature, Id id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    const ClassIds* classes = _classes.load(std::memory_order_relaxed);
+    typename ClassIds::const_iterator citr = classes->find(classId);
+    Ids* ids = citr == classes->end() ? new Ids() : new Ids(*citr->second);
+    (*ids)[name][signature] = id;
+    _idSnapshots.emplace_back(ids);
+    ClassIds* updated = new ClassIds(*classes);
+    (*updated)[classId] = ids;
+    _classSnapshots.emplace_back(updated);
+    _classes.store(updated, std::memory_order_release);
+}
+
+jmethodID Jni::getMethodId(jclass classId, const std::string& name, const std::string& signature, bool isStatic)
+{
+    if(!classId)
+    {
+        return nullptr;
+    }
+    IdCache<jmethodID>& methods = isStatic ? _staticMethods : _methods;
+    jmethodID methodId = nullptr;
+    if(methods.find(classId, name, signature, methodId))
+    {
+        _methodHits.fetch_add(1, std::memory_order_relaxed);
+        return methodId;
+    }
+    _methodMisses.fetch_add(1, std::memory_order_relaxed);
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return nullptr;
+    }
+    if(isStatic)
+    {
+        methodId = env->GetStaticMethodID(classId, name.c_str(), signature.c_str());
+    }
+    else
+    {
+        methodId = env->GetMethodID(classId, name.c_str(), signature.c_str());
+    }
+    if(methodId)
+    {
+        methods.add(classId, name, signature, methodId);
+    }
+    return methodId;
+}
+
+jfieldID Jni::getFieldId(jclass classId, const std::string& name, const std::string& signature, bool isStatic)
 {
+    if(!classId)
+    {
+        return nullptr;
+    }
+    IdCache<jfieldID>& fields = isStatic ? _staticFields : _fields;
+    jfieldID fieldId = nullptr;
+    if(fields.find(classId, name, signature, fieldId))
+    {
+        return fieldId;
+    }
     JNIEnv* env = getEnvironment();
-    _classPath = classPath;
-    std::replace(_classPath.begin(), _classPath.end(), '.', '/');
-    if(env)
+    if(!env)
+    {
+        return nullptr;
+    }
+    if(isStatic)
+    {
+        fieldId = env->GetStaticFieldID(classId, name.c_str(), signature.c_str());
+    }
+    else
+    {
+        fieldId = env->GetFieldID(classId, name.c_str(), signature.c_str());
+    }
+    if(fieldId)
+    {
+        fields.add(classId, name, signature, fieldId);
+    }
+    return fieldId;
+}
+
+unsigned long Jni::getMethodCacheHits() const
+{
+    return _methodHits;
+}
+
+JniString Jni::intern(const std::string& value)
+{
+    std::lock_guard<std::mutex> lock(_stringsMutex);
+    std::unordered_map<std::string, jstring>::const_iterator itr = _strings.find(value);
+    if(itr != _strings.end())
+    {
+        return JniString(itr->second);
+    }
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return JniString();
+    }
+    jstring local = JniObject::createJavaString(env, value);
+    if(!local)
+    {
+        env->ExceptionClear();
+        return JniString();
+    }
+    jstring str = (jstring)env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+    _strings[value] = str;
+    return JniString(str);
+}
+
+jobject Jni::getSingleton(const std::string& classPath)
+{
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return nullptr;
+    }
+    std::string fclassPath(classPath);
+    std::replace(fclassPath.begin(), fclassPath.end(), '.', '/');
+    SingletonAccess access = SingletonAccess::Unknown;
+    {
+        std::lock_guard<std::mutex> lock(_singletonsMutex);
+        std::unordered_map<std::string, SingletonEntry>::const_iterator itr = _singletons.find(fclassPath);
+        if(itr != _singletons.end())
+        {
+            if(itr->second.instance)
+            {
+                return env->NewLocalRef(itr->second.instance);
+            }
+            access = itr->second.access;
+        }
+    }
+    if(access == SingletonAccess::Missing)
+    {
+        return nullptr;
+    }
+    jclass classId = getClass(fclassPath);
+    if(!classId)
+    {
+        return nullptr;
+    }
+    std::string signature = std::string("L")+fclassPath+";";
+    jobject local = nullptr;
+    bool hasField = false;
+    bool hasMethod = false;
+    if(access != SingletonAccess::Method)
+    {
+        jfieldID fieldId = getFieldId(classId, "instance", signature, true);
+        if(fieldId)
+        {
+            hasField = true;
+            local = env->GetStaticObjectField(classId, fieldId);
+            if(local)
+            {
+                access = SingletonAccess::Field;
+            }
+        }
+        else
+        {
+            env->ExceptionClear();
+        }
+    }
+    if(!local && access != SingletonAccess::Field)
+    {
+        jmethodID methodId = getMethodId(classId, "getInstance", std::string("()")+signature, true);
+        if(methodId)
+        {
+            hasMethod = true;
+            local = env->CallStaticObjectMethodA(classId, methodId, nullptr);
+            access = SingletonAccess::Method;
+        }
+        if(env->ExceptionCheck())
+        {
+            env->ExceptionClear();
+            local = nullptr;
+        }
+    }
+    if(hasField && !hasMethod && access == SingletonAccess::Unknown)
+    {
+        // the field is there but not set yet, read it again next time
+        access = SingletonAccess::Field;
+    }
+    std::lock_guard<std::mutex> lock(_singletonsMutex);
+    SingletonEntry& entry = _singletons[fclassPath];
+    if(!local)
+    {
+        // only remember a miss if neither way to get the instance exists
+        if(!entry.instance)
+        {
+            entry.access = (hasField || hasMethod) ? access : SingletonAccess::Missing;
+        }
+        return nullptr;
+    }
+    if(!entry.instance)
+    {
+        entry.instance = env->NewGlobalRef(local);
+    }
+    entry.access = access;
+    return local;
+}
+
+void Jni::invalidateSingleton(const std::string& classPath)
+{
+    std::string fclassPath(classPath);
+    std::replace(fclassPath.begin(), fclassPath.end(), '.', '/');
+    JNIEnv* env = getEnvironment();
+    std::lock_guard<std::mutex> lock(_singletonsMutex);
+    for(std::pair<const std::string, SingletonEntry>& singleton : _singletons)
+    {
+        if(!fclassPath.empty() && singleton.first != fclassPath)
+        {
+            continue;
+        }
+        if(singleton.second.instance && env)
+        {
+            env->DeleteGlobalRef(singleton.second.instance);
+        }
+        singleton.second.instance = nullptr;
+        if(singleton.second.access == SingletonAccess::Missing)
+        {
+            singleton.second.access = SingletonAccess::Unknown;
+        }
+    }
+}
+
+unsigned long Jni::getMethodCacheMisses() const
+{
+    return _methodMisses;
+}
+
+#pragma mark - JniWorkerPool
+
+JniWorkerPool::JniWorkerPool(size_t count, const std::string& name) :
+_pending(0), _attached(count), _stopped(false), _next(0)
+{
+    for(size_t i=0; i<count; ++i)
+    {
+        _workers.emplace_back(new Worker());
+        _workers.back()->attached = true;
+    }
+    // start after all the queues exist, workers steal from each other
+    for(size_t i=0; i<count; ++i)
+    {
+        std::ostringstream os;
+        os << name << "-" << i;
+        _workers[i]->thread = std::thread(&JniWorkerPool::run, this, i, os.str());
+    }
+}
+
+JniWorkerPool::~JniWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopped = true;
+    }
+    _condition.notify_all();
+    for(const std::unique_ptr<Worker>& worker : _workers)
+    {
+        if(worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+size_t JniWorkerPool::size() const
+{
+    return _workers.size();
+}
+
+void JniWorkerPool::post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_attached == 0)
+        {
+            throw JniException("no attached workers");
+        }
+        Worker* worker = nullptr;
+        do
+        {
+            worker = _workers[_next++ % _workers.size()].get();
+        }
+        while(!worker->attached);
+        std::lock_guard<std::mutex> workerLock(worker->mutex);
+        worker->tasks.push_back(std::move(task));
+        _pending++;
+    }
+    _condition.notify_one();
+}
+
+bool JniWorkerPool::popTask(size_t index, Task& task)
+{
+    for(size_t i=0; i<_workers.size(); ++i)
+    {
+        Worker& worker = *_workers[(index+i) % _workers.size()];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if(worker.tasks.empty())
+        {
+            continue;
+        }
+        // the own queue is used from the front, stolen tasks come from the back
+        if(i == 0)
+        {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        else
+        {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void JniWorkerPool::stopWorker(size_t index)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _workers[index]->attached = false;
+    _attached--;
+    if(_attached > 0)
+    {
+        // the queued tasks are stolen by the other workers
+        return;
+    }
+    // nobody can run the queued tasks, dropping them breaks their promises
+    for(const std::unique_ptr<Worker>& worker : _workers)
+    {
+        std::lock_guard<std::mutex> workerLock(worker->mutex);
+        worker->tasks.clear();
+    }
+    _pending = 0;
+}
+
+void JniWorkerPool::run(size_t index, const std::string& name)
+{
+    JNIEnv* env = nullptr;
+    try
+    {
+        env = Jni::attachThread(name);
+    }
+    catch(const JniException&)
+    {
+        stopWorker(index);
+        return;
+    }
+    Task task;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this]{ return _stopped || _pending > 0; });
+            if(_pending == 0)
+            {
+                break;
+            }
+            _pending--;
+        }
+        if(!popTask(index, task))
+        {
+            // another worker took the task this one was woken for
+            // between the scans, give the count back
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _pending++;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        try
+        {
+            // workers never return to java, so free the refs of every task
+            JniLocalFrame frame(env);
+            task(env);
+        }
+        catch(...)
+        {
+        }
+        if(env->ExceptionCheck())
+        {
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+        task = nullptr;
+    }
+    Jni::detachThread();
+}
+
+#pragma mark - JniLocalFrame
+
+JniLocalFrame::JniLocalFrame(JNIEnv* env, jint chunk, bool active) :
+_env(active ? env : nullptr), _chunk(chunk), _count(0), _pushed(false)
+{
+    push();
+}
+
+JniLocalFrame::~JniLocalFrame()
+{
+    pop();
+}
+
+void JniLocalFrame::push()
+{
+    _count = 0;
+    if(!_env)
+    {
+        return;
+    }
+    // most loops create a couple of refs per iteration
+    _pushed = _env->PushLocalFrame(_chunk*2) == 0;
+    if(!_pushed)
+    {
+        // an OutOfMemoryError is pending
+        JniObject::checkJniException(_env);
+        throw JniException("could not push a local frame");
+    }
+}
+
+void JniLocalFrame::step()
+{
+    _count++;
+    if(_count >= _chunk)
+    {
+        renew();
+    }
+}
+
+void JniLocalFrame::renew()
+{
+    pop();
+    push();
+}
+
+jobject JniLocalFrame::pop(jobject result)
+{
+    if(!_pushed)
+    {
+        return result;
+    }
+    _pushed = false;
+    return _env->PopLocalFrame(result);
+}
+
+#pragma mark - JniObject
+ 
+JniObject::JniObject(const std::string& classPath, jobject objId, jclass classId) :
+_instance(nullptr), _class(nullptr), _local(false)
+{
+    init(objId, classId, classPath);
+}
+ 
+JniObject::JniObject(jclass classId, jobject objId) :
+_instance(nullptr), _class(nullptr), _local(false)
+{
+    init(objId, classId);
+}
+ 
+JniObject::JniObject(jobject objId) :
+_instance(nullptr), _class(nullptr), _local(false)
+{
+    init(objId);
+}
+ 
+JniObject::JniObject(const JniObject& other) :
+_instance(nullptr), _class(nullptr), _local(false)
+{
+    copy(other);
+}
+
+JniObject::JniObject(JniObject&& other) :
+_class(nullptr), _instance(nullptr), _local(false)
+{
+    move(other);
+}
+
+JniObject::JniObject(bool local, jobject objId, jclass classId, const std::string& classPath) :
+_class(nullptr), _instance(nullptr), _local(local)
+{
+    init(objId, classId, classPath);
+}
+
+void JniObject::copy(const JniObject& other)
+{
+    if(other._shared)
+    {
+        _shared = other._shared;
+        _class = other._class;
+        _instance = other._instance;
+        _classPath = other._classPath;
+    }
+    else
+    {
+        init(other._instance, other._class, other._classPath);
+    }
+    _cacheClass = other._cacheClass;
+}
+
+void JniObject::move(JniObject& other)
+{
+    if(_local != other._local)
+    {
+        copy(other);
+        other.clear();
+        return;
+    }
+    _class = other._class;
+    _instance = other._instance;
+    _classPath = std::move(other._classPath);
+    _cacheClass = other._cacheClass;
+    _shared = std::move(other._shared);
+    other._class = nullptr;
+    other._instance = nullptr;
+}
+ 
+void JniObject::init(jobject objId, jclass classId, const std::string& classPath)
+{
+    JNIEnv* env = getEnvironment();
+    _classPath = classPath;
+    std::replace(_classPath.begin(), _classPath.end(), '.', '/');
+    if(env)
+    {
+        jclass objClassId = nullptr;
+        if(!classId)
+        {
+            if(!classPath.empty())
+            {
+                classId = Jni::get().getClass(_classPath);
+            }
+            else if(objId)
+            {
+                classId = objClassId = env->GetObjectClass(objId);
+            }
+        }
+        if(classId)
+        {
+            _class = (jclass)(_local ? env->NewLocalRef(classId) : env->NewGlobalRef(classId));
+        }
+        else
+        {
+            _classPath = "";
+        }
+        if(objClassId)
+        {
+            env->DeleteLocalRef(objClassId);
+        }
+        if(objId)
+        {
+            _instance = _local ? env->NewLocalRef(objId) : env->NewGlobalRef(objId);
+        }
+    }
+}
+ 
+JniObject::~JniObject()
+{
+    clear();
+}
+
+void JniObject::checkJniException()
+{
+    checkJniException(getEnvironment());
+}
+
+void JniObject::checkJniException(JNIEnv* env)
+{
+    if(!env)
+    {
+        return;
+    }
+    if (!env->ExceptionCheck())
+    {
+        return;
+    }
+    jthrowable throwable = env->ExceptionOccurred();
+    env->ExceptionClear();
+    JniLocalObject exc("java/lang/Throwable", throwable);
+    env->DeleteLocalRef(throwable);
+    if(exc)
+    {
+        std::string msg = exc.getClassPath()+": ";
+        msg += exc.call("getLocalizedMessage", msg);
+        throw JniException(msg);
+    }
+
+}
+ 
+bool JniObject::checkCallException(JNIEnv* env)
+{
+    if(!JniSession::isDeferringChecks())
+    {
+        checkJniException(env);
+        return true;
+    }
+    if(env->ExceptionCheck())
+    {
+        JniSession::recordException(env);
+    }
+    return !JniSession::hasFailed();
+}
+
+JniObject JniObject::takeJniException(JNIEnv* env)
+{
+    jthrowable throwable = env->ExceptionOccurred();
+    env->ExceptionClear();
+    JniObject exc(throwable);
+    env->DeleteLocalRef(throwable);
+    return exc;
+}
+
+JniError JniObject::checkCall(JNIEnv* env, bool isStatic) const
+{
+    if(!env)
+    {
+        return JniError::NoEnvironment;
+    }
+    if(!getClass())
+    {
+        return JniError::NoClass;
+    }
+    if(!isStatic && !getInstance())
+    {
+        return JniError::NoObject;
+    }
+    return JniError::None;
+}
+
+JniObject::SharedRefs::~SharedRefs()
+{
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return;
+    }
+    if(classId)
+    {
+        env->DeleteGlobalRef(classId);
+    }
+    if(instance)
+    {
+        env->DeleteGlobalRef(instance);
+    }
+}
+
+void JniObject::makeShared()
+{
+    if(_shared || _local)
+    {
+        return;
+    }
+    _shared = std::make_shared<SharedRefs>();
+    _shared->classId = _class;
+    _shared->instance = _instance;
+}
+
+bool JniObject::isShared() const
+{
+    return _shared != nullptr;
+}
+
+void JniObject::clear()
+{
+    _cacheClass = nullptr;
+    if(_shared)
+    {
+        _shared.reset();
+        _class = nullptr;
+        _instance = nullptr;
+        return;
+    }
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return;
+    }
+    if(_class)
+    {
+        if(_local)
+        {
+            env->DeleteLocalRef(_class);
+        }
+        else
+        {
+            env->DeleteGlobalRef(_class);
+        }
+        _class = nullptr;
+    }
+    if(_instance)
+    {
+        if(_local)
+        {
+            env->DeleteLocalRef(_instance);
+        }
+        else
+        {
+            env->DeleteGlobalRef(_instance);
+        }
+        _instance = nullptr;
+    }
+}
+ 
+std::string JniObject::getSignature() const
+{
+    return getClassSignature(getClassPath());
+}
+
+std::string JniObject::getClassSignature(const std::string& classPath)
+{
+    // array class names already are signatures
+    if(!classPath.empty() && classPath[0] == '[')
+    {
+        return classPath;
+    }
+    return std::string("L")+classPath+";";
+}
+ 
+const std::string& JniObject::getClassPath() const
+{
+    if(_classPath.empty() && _class)
+    {
+        _classPath = Jni::get().getClassPath(_class);
+    }
+    return _classPath;
+}
+ 
+jclass JniObject::getCacheClass() const
+{
+    if(!_cacheClass && _class)
+    {
+        const std::string& classPath = getClassPath();
+        if(!classPath.empty())
+        {
+            Jni& jni = Jni::get();
+            _cacheClass = jni.getClass(classPath);
+            if(!_cacheClass)
+            {
+                _cacheClass = jni.registerClass(classPath, _class);
+            }
+        }
+    }
+    return _cacheClass;
+}
+
+jmethodID JniObject::getMethodId(JNIEnv* env, const std::string& name, const std::string& signature, bool isStatic) const
+{
+    jclass classId = getCacheClass();
+    if(classId)
+    {
+        return Jni::get().getMethodId(classId, name, signature, isStatic);
+    }
+    if(isStatic)
+    {
+        return env->GetStaticMethodID(getClass(), name.c_str(), signature.c_str());
+    }
+    else
+    {
+        return env->GetMethodID(getClass(), name.c_str(), signature.c_str());
+    }
+}
+ 
+jfieldID JniObject::getFieldId(JNIEnv* env, const std::string& name, const std::string& signature, bool isStatic) const
+{
+    jclass classId = getCacheClass();
+    if(classId)
+    {
+        return Jni::get().getFieldId(classId, name, signature, isStatic);
+    }
+    if(isStatic)
+    {
+        return env->GetStaticFieldID(getClass(), name.c_str(), signature.c_str());
+    }
+    else
+    {
+        return env->GetFieldID(getClass(), name.c_str(), signature.c_str());
+    }
+}
+
+jclass JniObject::resolveClass(const std::string& classPath)
+{
+    std::string fclassPath(classPath);
+    std::replace(fclassPath.begin(), fclassPath.end(), '.', '/');
+    jclass classId = Jni::get().getClass(fclassPath);
+    if(!classId)
+    {
+        throw JniException("no class found");
+    }
+    return classId;
+}
+
+jmethodID JniObject::resolveMethod(jclass classId, const std::string& name, const std::string& signature, bool isStatic)
+{
+    jmethodID methodId = Jni::get().getMethodId(classId, name, signature, isStatic);
+    checkJniException();
+    if(!methodId)
+    {
+        throw JniException("no method found");
+    }
+    return methodId;
+}
+
+JniObject JniObject::createNewWithCapacity(const std::string& classPath, jint capacity)
+{
+    JNIEnv* env = getEnvironment();
+    jclass classId = Jni::get().getClass(classPath);
+    if(!env || !classId)
+    {
+        return createNew(classPath);
+    }
+    jmethodID methodId = Jni::get().getMethodId(classId, "<init>", "(I)V");
+    if(!methodId)
+    {
+        env->ExceptionClear();
+        return createNew(classPath);
+    }
+    jvalue arg;
+    arg.i = capacity;
+    jobject obj = env->NewObjectA(classId, methodId, &arg);
+    checkJniException(env);
+    JniObject result(classPath, obj, classId);
+    env->DeleteLocalRef(obj);
+    return result;
+}
+
+JniObject::BoxedMethods JniObject::resolveBoxedMethods(const char* classPath, const char* valueOfSignature, const char* valueName, const char* valueSignature)
+{
+    BoxedMethods methods;
+    methods.classId = resolveClass(classPath);
+    methods.valueOf = resolveMethod(methods.classId, "valueOf", valueOfSignature, true);
+    methods.value = resolveMethod(methods.classId, valueName, valueSignature, false);
+    return methods;
+}
+
+jobjectArray JniObject::createStreamBoxedArray(JNIEnv* env, jarray arr, jclass streamClass, const char* streamSignature)
+{
+    jclass arraysClass = resolveClass("java/util/Arrays");
+    jclass objectStreamClass = resolveClass("java/util/stream/Stream");
+    jmethodID stream = resolveMethod(arraysClass, "stream", streamSignature, true);
+    jmethodID boxed = resolveMethod(streamClass, "boxed", "()Ljava/util/stream/Stream;", false);
+    jmethodID toArray = resolveMethod(objectStreamClass, "toArray", "()[Ljava/lang/Object;", false);
+    jvalue arg;
+    arg.l = arr;
+    jobject primitives = env->CallStaticObjectMethodA(arraysClass, stream, &arg);
+    checkJniException(env);
+    jobject objects = env->CallObjectMethodA(primitives, boxed, nullptr);
+    env->DeleteLocalRef(primitives);
+    checkJniException(env);
+    jobjectArray result = (jobjectArray)env->CallObjectMethodA(objects, toArray, nullptr);
+    env->DeleteLocalRef(objects);
+    checkJniException(env);
+    return result;
+}
+
+JniObject::BufferMethods JniObject::resolveBufferMethods()
+{
+    BufferMethods methods;
+    jclass byteOrderClass = resolveClass("java/nio/ByteOrder");
+    jclass bufferClass = resolveClass("java/nio/Buffer");
+    methods.order = resolveMethod(getByteBufferClass(), "order", "(Ljava/nio/ByteOrder;)Ljava/nio/ByteBuffer;", false);
+    methods.position = resolveMethod(bufferClass, "position", "()I", false);
+    methods.limit = resolveMethod(bufferClass, "limit", "()I", false);
+    JNIEnv* env = getEnvironment();
+    jobject order = env->CallStaticObjectMethodA(byteOrderClass,
+        resolveMethod(byteOrderClass, "nativeOrder", "()Ljava/nio/ByteOrder;", true), nullptr);
+    checkJniException(env);
+    methods.nativeOrder = env->NewGlobalRef(order);
+    env->DeleteLocalRef(order);
+    return methods;
+}
+
+const JniObject::BufferMethods& JniObject::getBufferMethods()
+{
+    static const BufferMethods methods = resolveBufferMethods();
+    return methods;
+}
+
+JNIEnv* JniObject::getEnvironment()
+{
+    JNIEnv* env = JniSession::getCurrentEnvironment();
+    if(env)
+    {
+        return env;
+    }
+    return Jni::getEnvironment();
+}
+ 
+jclass JniObject::getClass() const
+{
+    return _class;
+}
+ 
+jobject JniObject::getInstance() const
+{
+    return _instance;
+}
+ 
+jobject JniObject::getNewLocalInstance() const
+{
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return 0;
+    }
+    return env->NewLocalRef(getInstance());
+}
+ 
+bool JniObject::isInstanceOf(const std::string& classPath) const
+{
+    std::string fclassPath(classPath);
+    std::replace(fclassPath.begin(), fclassPath.end(), '.', '/');
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        return false;
+    }
+    jclass cls = Jni::get().getClass(fclassPath);
+    if(!cls)
+    {
+        return false;
+    }
+    return env->IsInstanceOf(getInstance(), cls);
+}
+
+jclass JniObject::getCollectionClass()
+{
+    static const jclass cls = resolveClass("java/util/Collection");
+    return cls;
+}
+
+jclass JniObject::getMapClass()
+{
+    static const jclass cls = resolveClass("java/util/Map");
+    return cls;
+}
+
+jclass JniObject::getByteBufferClass()
+{
+    static const jclass cls = resolveClass("java/nio/ByteBuffer");
+    return cls;
+}
+ 
+JniObject JniObject::findSingleton(const std::string& classPath)
+{
+    std::string fclassPath(classPath);
+    std::replace(fclassPath.begin(), fclassPath.end(), '.', '/');
+    jobject instance = Jni::get().getSingleton(fclassPath);
+    if(!instance)
+    {
+        throw JniException("Could not find singleton instance.");
+    }
+    JniObject singleton(fclassPath, instance);
+    getEnvironment()->DeleteLocalRef(instance);
+    return singleton;
+}
+ 
+JniObject JniObject::createDirectBuffer(void* data, size_t size)
+{
+    JNIEnv* env = getEnvironment();
+    if(!env)
+    {
+        throw JniException("no environment found");
+    }
+    jobject buffer = env->NewDirectByteBuffer(data, size);
+    checkJniException();
+    if(!buffer)
+    {
+        throw JniException("direct buffers are not supported");
+    }
+    JniObject obj("java/nio/ByteBuffer", buffer);
+    env->DeleteLocalRef(buffer);
+    // java defaults to big endian, native code reads the memory directly
+    const BufferMethods& methods = getBufferMethods();
+    jvalue arg;
+    arg.l = methods.nativeOrder;
+    jobject ordered = env->CallObjectMethodA(obj.getInstance(), methods.order, &arg);
+    checkJniException(env);
+    env->DeleteLocalRef(ordered);
+    return obj;
+}
+
+void* JniObject::getDirectBufferBytes(size_t& size) const
+{
+    size = 0;
+    JNIEnv* env = getEnvironment();
+    jobject buffer = getInstance();
+    if(!env || !buffer || !env->IsInstanceOf(buffer, getByteBufferClass()))
+    {
+        return nullptr;
+    }
+    uint8_t* data = static_cast<uint8_t*>(env->GetDirectBufferAddress(buffer));
+    if(!data)
+    {
+        return nullptr;
+    }
+    const BufferMethods& methods = getBufferMethods();
+    jint position = env->CallIntMethodA(buffer, methods.position, nullptr);
+    checkJniException(env);
+    jint limit = env->CallIntMethodA(buffer, methods.limit, nullptr);
+    checkJniException(env);
+    if(limit <= position)
+    {
+        return nullptr;
+    }
+    size = limit - position;
+    return data + position;
+}
+ 
+#pragma mark - JniObject strings
+
+// reused by the string conversions of each thread
+static thread_local std::vector<jchar> stringBuffer;
+
+static const uint64_t asciiMask8 = 0x8080808080808080ULL;
+static const uint64_t asciiMask16 = 0xFF80FF80FF80FF80ULL;
+
+/**
+ * Standard utf-8 to utf-16, invalid sequences are replaced with U+FFFD
+ * The output needs as many units as the input has bytes
+ */
+static size_t transcodeUtf8ToUtf16(const char* data, size_t size, jchar* out)
+{
+    const uint8_t* in = (const uint8_t*)data;
+    const uint8_t* end = in + size;
+    jchar* start = out;
+    while(in < end)
+    {
+        // widen runs of ascii a word at a time
+        while(end - in >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, in, sizeof(word));
+            if(word & asciiMask8)
+            {
+                break;
+            }
+            for(size_t i=0; i<8; ++i)
+            {
+                out[i] = in[i];
+            }
+            in += 8;
+            out += 8;
+        }
+        if(in == end)
+        {
+            break;
+        }
+        uint32_t c = *in;
+        size_t len = 1;
+        uint32_t min = 0;
+        if(c < 0x80)
+        {
+            *out++ = c;
+            in++;
+            continue;
+        }
+        else if((c & 0xE0) == 0xC0)
+        {
+            len = 2;
+            c &= 0x1F;
+            min = 0x80;
+        }
+        else if((c & 0xF0) == 0xE0)
+        {
+            len = 3;
+            c &= 0x0F;
+            min = 0x800;
+        }
+        else if((c & 0xF8) == 0xF0)
+        {
+            len = 4;
+            c &= 0x07;
+            min = 0x10000;
+        }
+        else
+        {
+            *out++ = 0xFFFD;
+            in++;
+            continue;
+        }
+        size_t i = 1;
+        for(; i<len && in+i<end && (in[i] & 0xC0) == 0x80; ++i)
+        {
+            c = (c << 6) | (in[i] & 0x3F);
+        }
+        in += i;
+        if(i < len || c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+        {
+            *out++ = 0xFFFD;
+        }
+        else if(c >= 0x10000)
+        {
+            c -= 0x10000;
+            *out++ = 0xD800 + (c >> 10);
+            *out++ = 0xDC00 + (c & 0x3FF);
+        }
+        else
+        {
+            *out++ = c;
+        }
+    }
+    return out - start;
+}
+
+/**
+ * Utf-16 to standard utf-8, lone surrogates are replaced with U+FFFD
+ */
+static void transcodeUtf16ToUtf8(const jchar* in, size_t size, std::string& result)
+{
+    // every unit needs at most three bytes, a surrogate pair needs four
+    result.resize(size*3);
+    if(size == 0)
+    {
+        return;
+    }
+    char* start = &result[0];
+    char* out = start;
+    size_t i = 0;
+    while(i < size)
     {
-        if(!classId)
+        // copy runs of ascii four units at a time
+        while(size - i >= 4)
         {
-            if(!classPath.empty())
-            {
-                classId = Jni::get().getClass(_classPath);
-            }
-            else if(objId)
+            uint64_t word;
+            memcpy(&word, in+i, sizeof(word));
+            if(word & asciiMask16)
             {
-                classId = env->GetObjectClass(objId);
+                break;
             }
+            out[0] = (char)in[i];
+            out[1] = (char)in[i+1];
+            out[2] = (char)in[i+2];
+            out[3] = (char)in[i+3];
+            out += 4;
+            i += 4;
         }
-        if(classId)
+        if(i == size)
         {
-            _class = (jclass)env->NewGlobalRef(classId);
+            break;
         }
-        else
+        uint32_t c = in[i++];
+        if(c < 0x80)
         {
-            _classPath = "";
+            *out++ = (char)c;
         }
-        if(objId)
+        else if(c < 0x800)
+        {
+            *out++ = (char)(0xC0 | (c >> 6));
+            *out++ = (char)(0x80 | (c & 0x3F));
+        }
+        else if(c >= 0xD800 && c <= 0xDBFF && i < size && in[i] >= 0xDC00 && in[i] <= 0xDFFF)
+        {
+            c = 0x10000 + ((c - 0xD800) << 10) + (in[i++] - 0xDC00);
+            *out++ = (char)(0xF0 | (c >> 18));
+            *out++ = (char)(0x80 | ((c >> 12) & 0x3F));
+            *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (c & 0x3F));
+        }
+        else
         {
-            _instance = env->NewGlobalRef(objId);
+            if(c >= 0xD800 && c <= 0xDFFF)
+            {
+                c = 0xFFFD;
+            }
+            *out++ = (char)(0xE0 | (c >> 12));
+            *out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            *out++ = (char)(0x80 | (c & 0x3F));
         }
     }
+    result.resize(out - start);
 }
- 
-JniObject::~JniObject()
+
+jstring JniObject::createJavaString(JNIEnv* env, const std::string& str)
 {
-    clear();
+    if(stringBuffer.size() < str.size())
+    {
+        stringBuffer.resize(str.size());
+    }
+    size_t len = transcodeUtf8ToUtf16(str.data(), str.size(), stringBuffer.data());
+    return env->NewString(stringBuffer.data(), (jsize)len);
 }
 
-void JniObject::checkJniException()
+bool JniObject::convertFromJavaString(JNIEnv* env, jstring str, std::string& out)
 {
-    JNIEnv* env = getEnvironment();
-    if(!env)
+    if(!str)
     {
-        return;
+        out.clear();
+        return true;
     }
-    if (!env->ExceptionCheck())
+    jsize len = env->GetStringLength(str);
+    if(len < 0)
     {
-        return;
+        return false;
     }
-    JniObject exc("java/lang/Throwable", env->ExceptionOccurred());
-    if(exc)
+    if(stringBuffer.size() < (size_t)len)
     {
-        env->ExceptionClear();
-        std::string msg = exc.getClassPath()+": ";
-        msg += exc.call("getLocalizedMessage", msg);
-        throw JniException(msg);
+        stringBuffer.resize(len);
     }
+    env->GetStringRegion(str, 0, len, stringBuffer.data());
+    transcodeUtf16ToUtf8(stringBuffer.data(), len, out);
+    return true;
+}
 
+#pragma mark - JniSession
+
+thread_local JniSession* JniSession::_current = nullptr;
+
+JniSession::JniSession(bool deferChecks, jint frameChunk) :
+_env(Jni::getEnvironment()), _frame(_env, frameChunk),
+_deferChecks(deferChecks), _exception(nullptr), _parent(_current)
+{
+    _current = this;
 }
- 
-void JniObject::clear()
+
+JniSession::~JniSession()
 {
-    JNIEnv* env = getEnvironment();
-    if(!env)
+    _current = _parent;
+    if(!_env)
     {
         return;
     }
-    if(_class)
+    restoreException();
+    if(_env->ExceptionCheck())
     {
-        env->DeleteGlobalRef(_class);
-        _class = nullptr;
+        _env->ExceptionDescribe();
+        _env->ExceptionClear();
     }
-    if(_instance)
+}
+
+void JniSession::restoreException()
+{
+    if(!_exception)
     {
-        env->DeleteGlobalRef(_instance);
-        _instance = nullptr;
+        return;
     }
+    _env->ExceptionClear();
+    _env->Throw(_exception);
+    _env->DeleteGlobalRef(_exception);
+    _exception = nullptr;
 }
- 
-std::string JniObject::getSignature() const
+
+JNIEnv* JniSession::getEnvironment() const
 {
-    return std::string("L")+getClassPath()+";";
+    return _env;
 }
- 
-const std::string& JniObject::getClassPath() const
+
+void JniSession::check()
 {
-    if(_classPath.empty() && _class)
-    {
-        try
-        {
-            _classPath = JniObject("java/lang/Class", _class).call("getName", _classPath);
-        }
-        catch(JniException e)
-        {
-        }
-    }
-    return _classPath;
+    restoreException();
+    JniObject::checkJniException(_env);
 }
- 
-JNIEnv* JniObject::getEnvironment()
+
+bool JniSession::isDeferringChecks()
 {
-    return Jni::get().getEnvironment();
+    return _current && _current->_deferChecks;
 }
- 
-jclass JniObject::getClass() const
+
+JNIEnv* JniSession::getCurrentEnvironment()
 {
-    return _class;
+    return _current ? _current->_env : nullptr;
 }
- 
-jobject JniObject::getInstance() const
+
+bool JniSession::hasFailed()
 {
-    return _instance;
+    return _current && _current->_exception;
 }
- 
-jobject JniObject::getNewLocalInstance() const
+
+void JniSession::recordException(JNIEnv* env)
 {
-    JNIEnv* env = getEnvironment();
-    if(!env)
+    jthrowable throwable = env->ExceptionOccurred();
+    env->ExceptionClear();
+    if(_current && !_current->_exception && throwable)
     {
-        return 0;
+        _current->_exception = static_cast<jthrowable>(env->NewGlobalRef(throwable));
     }
-    return env->NewLocalRef(getInstance());
+    env->DeleteLocalRef(throwable);
 }
- 
-bool JniObject::isInstanceOf(const std::string& classPath) const
+
+#pragma mark - JniResult
+
+JniResultBase::JniResultBase(JniError error) :
+_error(error)
 {
-    std::string fclassPath(classPath);
-    std::replace(fclassPath.begin(), fclassPath.end(), '.', '/');
-    JNIEnv* env = getEnvironment();
-    if(!env)
-    {
-        return false;
-    }
-    jclass cls = env->FindClass(fclassPath.c_str());
-    return env->IsInstanceOf(getInstance(), cls);
 }
- 
-JniObject JniObject::findSingleton(const std::string& classPath)
+
+JniResultBase::JniResultBase(JniError error, const JniObject& exception) :
+_error(error), _exception(std::make_shared<JniObject>(exception))
 {
-    JniObject cls(classPath);
-    try
+}
+
+JniResultBase::operator bool() const
+{
+    return _error == JniError::None;
+}
+
+JniError JniResultBase::getError() const
+{
+    return _error;
+}
+
+JniObject JniResultBase::getException() const
+{
+    return _exception ? *_exception : JniObject();
+}
+
+std::string JniResultBase::getMessage() const
+{
+    switch(_error)
     {
-        return cls.staticField("instance", cls);
+        case JniError::None:
+            return "";
+        case JniError::NoEnvironment:
+            return "no environment found";
+        case JniError::NoClass:
+            return "no class found";
+        case JniError::NoObject:
+            return "no object found";
+        case JniError::NoMethod:
+            return "no method found";
+        case JniError::NoField:
+            return "no field found";
+        case JniError::JavaException:
+            break;
     }
-    catch(JniException e)
+    if(!_exception)
     {
+        return "java exception";
     }
-    try
+    std::string msg = _exception->getClassPath()+": ";
+    JniResult<std::string> localized = JniLocalObject(*_exception).tryCall("getLocalizedMessage", msg);
+    if(localized)
     {
-        return cls.staticCall("getInstance", cls);
+        msg += localized.getValue();
     }
-    catch(JniException e)
+    return msg;
+}
+
+void JniResultBase::check() const
+{
+    if(!*this)
     {
-    }    
-    throw JniException("Could not find singleton instance.");
+        throw JniException(getMessage());
+    }
 }
- 
+
+#pragma mark - JniLocalObject
+
+JniLocalObject::JniLocalObject(const std::string& classPath, jobject objId, jclass classId) :
+JniObject(true, objId, classId, classPath)
+{
+}
+
+JniLocalObject::JniLocalObject(jclass classId, jobject objId) :
+JniObject(true, objId, classId, "")
+{
+}
+
+JniLocalObject::JniLocalObject(jobject objId) :
+JniObject(true, objId, nullptr, "")
+{
+}
+
+JniLocalObject::JniLocalObject(const JniObject& other) :
+JniObject(true, nullptr, nullptr, "")
+{
+    copy(other);
+}
+
+JniLocalObject::JniLocalObject(const JniLocalObject& other) :
+JniObject(true, nullptr, nullptr, "")
+{
+    copy(other);
+}
+
+#pragma mark - JniObject operators
+
 JniObject::operator bool() const
 {
     return getInstance() != nullptr;
@@ -297,9 +1756,21 @@ JniObject::operator bool() const
  
 JniObject& JniObject::operator=(const JniObject& other)
 {
-    clear();
-    _classPath = other._classPath;
-    init(other._instance, other._class);
+    if(this != &other)
+    {
+        clear();
+        copy(other);
+    }
+    return *this;
+}
+
+JniObject& JniObject::operator=(JniObject&& other)
+{
+    if(this != &other)
+    {
+        clear();
+        move(other);
+    }
     return *this;
 }
  
@@ -329,12 +1800,24 @@ std::string JniObject::getSignaturePart<std::string>(const std::string& val)
     return "Ljava/lang/String;";
 }
  
+template<>
+std::string JniObject::getSignaturePart(const JniString& val)
+{
+    return "Ljava/lang/String;";
+}
+ 
 template<>
 std::string JniObject::getSignaturePart(const JniObject& val)
 {
     return val.getSignature();
 }
  
+template<>
+std::string JniObject::getSignaturePart(const JniLocalObject& val)
+{
+    return val.getSignature();
+}
+ 
 template<>
 std::string JniObject::getSignaturePart(const bool& val)
 {
@@ -398,7 +1881,15 @@ std::string JniObject::getSignaturePart(const float& val)
 template<>
 std::string JniObject::getSignaturePart(const jobject& val)
 {
-    return getSignaturePart(JniObject(val));
+    JNIEnv* env = getEnvironment();
+    if(!val || !env)
+    {
+        return "Ljava/lang/Object;";
+    }
+    jclass classId = env->GetObjectClass(val);
+    std::string signature = getClassSignature(Jni::get().getClassPath(classId));
+    env->DeleteLocalRef(classId);
+    return signature;
 }
  
 std::string JniObject::getSignaturePart()
@@ -455,162 +1946,76 @@ jvalue JniObject::convertToJavaValue(const unsigned int& obj)
     val.i = obj;
     return val;
 }
- 
-template<>
-jvalue JniObject::convertToJavaValue(const long& obj)
-{
-    jvalue val;
-    val.j = obj;
-    return val;
-}
- 
-template<>
-jvalue JniObject::convertToJavaValue(const long long& obj)
-{
-    jvalue val;
-    val.j = obj;
-    return val;
-}
-
-template<>
-jvalue JniObject::convertToJavaValue(const float& obj)
-{
-    jvalue val;
-    val.f = obj;
-    return val;
-}
- 
-template<>
-jvalue JniObject::convertToJavaValue(const double& obj)
-{
-    jvalue val;
-    val.d = obj;
-    return val;
-}
- 
-template<>
-jvalue JniObject::convertToJavaValue(const jobject& obj)
-{
-    jvalue val;
-    val.l = obj;
-    return val;
-}
- 
-template<>
-jvalue JniObject::convertToJavaValue(const JniObject& obj)
-{
-    return convertToJavaValue(obj.getInstance());
-}
- 
-template<>
-jvalue JniObject::convertToJavaValue(const std::string& obj)
-{
-    JNIEnv* env = getEnvironment();
-    if (!env)
-    {
-        return jvalue();
-    }
-    return convertToJavaValue(env->NewStringUTF(obj.c_str()));
-}
-
-#pragma mark - JniObject::isObjectArgument
-
-template<>
-bool JniObject::isObjectArgument(const bool& obj)
-{
-    return false;
-}
-
-template<>
-bool JniObject::isObjectArgument(const jboolean& obj)
-{
-    return false;
-}
-
-template<>
-bool JniObject::isObjectArgument(const jbyte& obj)
-{
-    return false;
-}
-
-template<>
-bool JniObject::isObjectArgument(const jchar& obj)
-{
-    return false;
-}
-
-template<>
-bool JniObject::isObjectArgument(const jshort& obj)
-{
-    return false;
-}
-
-template<>
-bool JniObject::isObjectArgument(const jint& obj)
-{
-    return false;
-}
-
-template<>
-bool JniObject::isObjectArgument(const unsigned int& obj)
-{
-    return false;
-}
-
+ 
 template<>
-bool JniObject::isObjectArgument(const long& obj)
+jvalue JniObject::convertToJavaValue(const long& obj)
 {
-    return false;
+    jvalue val;
+    val.j = obj;
+    return val;
 }
-
+ 
 template<>
-bool JniObject::isObjectArgument(const jlong& obj)
+jvalue JniObject::convertToJavaValue(const long long& obj)
 {
-    return false;
+    jvalue val;
+    val.j = obj;
+    return val;
 }
 
 template<>
-bool JniObject::isObjectArgument(const jfloat& obj)
+jvalue JniObject::convertToJavaValue(const float& obj)
 {
-    return false;
+    jvalue val;
+    val.f = obj;
+    return val;
 }
-
+ 
 template<>
-bool JniObject::isObjectArgument(const jdouble& obj)
+jvalue JniObject::convertToJavaValue(const double& obj)
 {
-    return false;
+    jvalue val;
+    val.d = obj;
+    return val;
 }
-
+ 
 template<>
-bool JniObject::isObjectArgument(const jobject& obj)
+jvalue JniObject::convertToJavaValue(const jobject& obj)
 {
-    return false;
+    jvalue val;
+    val.l = obj;
+    return val;
 }
-
+ 
 template<>
-bool JniObject::isObjectArgument(const JniObject& obj)
+jvalue JniObject::convertToJavaValue(const JniObject& obj)
 {
-    return false;
+    return convertToJavaValue(obj.getInstance());
 }
-
+ 
 template<>
-bool JniObject::isObjectArgument(const jarray& obj)
+jvalue JniObject::convertToJavaValue(const JniLocalObject& obj)
 {
-    return false;
+    return convertToJavaValue(obj.getInstance());
 }
-
+ 
 template<>
-bool JniObject::isObjectArgument(const jstring& obj)
+jvalue JniObject::convertToJavaValue(const JniString& obj)
 {
-    return false;
+    return convertToJavaValue(obj.getInstance());
 }
 
 template<>
-bool JniObject::isObjectArgument(const std::string& obj)
+jvalue JniObject::convertToJavaValue(const std::string& obj)
 {
-    return true;
+    JNIEnv* env = getEnvironment();
+    if (!env)
+    {
+        return jvalue();
+    }
+    return convertToJavaValue(JniObject::createJavaString(env, obj));
 }
- 
+
 #pragma mark - JniObject::convertFromJavaObject
  
 template<>
@@ -621,15 +2026,7 @@ bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, std::string& out
         out = "";
         return true;
     }
-    jstring jstr = (jstring)obj;
-    const char* chars = env->GetStringUTFChars(jstr, NULL);
-    if(!chars)
-    {
-        return false;
-    }
-    out = chars;
-    env->ReleaseStringUTFChars(jstr, chars);
-    return true;
+    return convertFromJavaString(env, (jstring)obj, out);
 }
  
 template<>
@@ -643,57 +2040,49 @@ bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, JniObject& out)
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, int& out)
 {
-    out = JniObject("java/lang/Integer", obj).call("intValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
 
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, float& out)
 {
-    out = JniObject("java/lang/Float", obj).call("floatValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
 
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, double& out)
 {
-    out = JniObject("java/lang/Double", obj).call("doubleValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
 
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, bool& out)
 {
-    out = JniObject("java/lang/Boolean", obj).call("booleanValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
 
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, uint8_t& out)
 {
-    out = JniObject("java/lang/Byte", obj).call("byteValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
 
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, short& out)
 {
-    out = JniObject("java/lang/Short", obj).call("shortValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
  
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, char& out)
 {
-    out = JniObject("java/lang/Character", obj).call("charValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
  
 template<>
 bool JniObject::convertFromJavaObject(JNIEnv* env, jobject obj, long& out)
 {
-    out = JniObject("java/lang/Long", obj).call("longValue", out);
-    return true;
+    return unboxJavaValue(env, obj, out);
 }
 
 #pragma mark - JniObject call jni
@@ -704,6 +2093,30 @@ void JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID meth
     return env->CallStaticVoidMethodA(classId, methodId, args);
 }
  
+template<>
+bool JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
+{
+    return env->CallStaticBooleanMethodA(classId, methodId, args);
+}
+ 
+template<>
+char JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
+{
+    return env->CallStaticCharMethodA(classId, methodId, args);
+}
+ 
+template<>
+short JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
+{
+    return env->CallStaticShortMethodA(classId, methodId, args);
+}
+ 
+template<>
+uint8_t JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
+{
+    return env->CallStaticByteMethodA(classId, methodId, args);
+}
+ 
 template<>
 jobject JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
 {
@@ -737,13 +2150,23 @@ int JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID metho
 template<>
 std::string JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
 {
-    return convertFromJavaObject<std::string>(env, callStaticJavaMethod<jobject>(env, classId, methodId, args));
+    jobject jout = callStaticJavaMethod<jobject>(env, classId, methodId, args);
+    if(!checkCallException(env))
+    {
+        return std::string();
+    }
+    return convertFromJavaObject<std::string>(env, jout);
 }
  
 template<>
 JniObject JniObject::callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
 {
-    return convertFromJavaObject<JniObject>(env, callStaticJavaMethod<jobject>(env, classId, methodId, args));
+    jobject jout = callStaticJavaMethod<jobject>(env, classId, methodId, args);
+    if(!checkCallException(env))
+    {
+        return JniObject();
+    }
+    return convertFromJavaObject<JniObject>(env, jout);
 }
  
 void JniObject::callJavaVoidMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args)
@@ -751,6 +2174,28 @@ void JniObject::callJavaVoidMethod(JNIEnv* env, jobject objId, jmethodID methodI
     env->CallVoidMethodA(objId, methodId, args);
 }
  
+template<>
+void JniObject::callCheckedJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args)
+{
+    if(JniSession::hasFailed())
+    {
+        return;
+    }
+    callJavaVoidMethod(env, objId, methodId, args);
+    checkCallException(env);
+}
+ 
+template<>
+void JniObject::callCheckedStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
+{
+    if(JniSession::hasFailed())
+    {
+        return;
+    }
+    callStaticJavaMethod<void>(env, classId, methodId, args);
+    checkCallException(env);
+}
+ 
 template<>
 void JniObject::callJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, bool& out)
 {
@@ -856,13 +2301,23 @@ int JniObject::getJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId)
 template<>
 std::string JniObject::getJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId)
 {
-    return convertFromJavaObject<std::string>(getJavaStaticField<jobject>(env, classId, fieldId));
+    jobject jout = getJavaStaticField<jobject>(env, classId, fieldId);
+    if(!checkCallException(env))
+    {
+        return std::string();
+    }
+    return convertFromJavaObject<std::string>(env, jout);
 }
  
 template<>
 JniObject JniObject::getJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId)
 {
-    return convertFromJavaObject<JniObject>(getJavaStaticField<jobject>(env, classId, fieldId));
+    jobject jout = getJavaStaticField<jobject>(env, classId, fieldId);
+    if(!checkCallException(env))
+    {
+        return JniObject();
+    }
+    return convertFromJavaObject<JniObject>(env, jout);
 }
  
 template<>
@@ -898,13 +2353,147 @@ int JniObject::getJavaField(JNIEnv* env, jobject objId, jfieldID fieldId)
 template<>
 std::string JniObject::getJavaField(JNIEnv* env, jobject objId, jfieldID fieldId)
 {
-    return convertFromJavaObject<std::string>(getJavaField<jobject>(env, objId, fieldId));
+    jobject jout = getJavaField<jobject>(env, objId, fieldId);
+    if(!checkCallException(env))
+    {
+        return std::string();
+    }
+    return convertFromJavaObject<std::string>(env, jout);
 }
  
 template<>
 JniObject JniObject::getJavaField(JNIEnv* env, jobject objId, jfieldID fieldId)
 {
-    return convertFromJavaObject<JniObject>(getJavaField<jobject>(env, objId, fieldId));
+    jobject jout = getJavaField<jobject>(env, objId, fieldId);
+    if(!checkCallException(env))
+    {
+        return JniObject();
+    }
+    return convertFromJavaObject<JniObject>(env, jout);
+}
+ 
+template<>
+bool JniObject::getJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId)
+{
+    return env->GetStaticBooleanField(classId, fieldId);
+}
+ 
+template<>
+bool JniObject::getJavaField(JNIEnv* env, jobject objId, jfieldID fieldId)
+{
+    return env->GetBooleanField(objId, fieldId);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const jobject& value)
+{
+    env->SetStaticObjectField(classId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const double& value)
+{
+    env->SetStaticDoubleField(classId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const long& value)
+{
+    env->SetStaticLongField(classId, fieldId, (jlong)value);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const jlong& value)
+{
+    env->SetStaticLongField(classId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const float& value)
+{
+    env->SetStaticFloatField(classId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const int& value)
+{
+    env->SetStaticIntField(classId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const bool& value)
+{
+    env->SetStaticBooleanField(classId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const std::string& value)
+{
+    jobject obj = createJavaString(env, value);
+    setJavaStaticField(env, classId, fieldId, obj);
+    env->DeleteLocalRef(obj);
+}
+ 
+template<>
+void JniObject::setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const JniObject& value)
+{
+    setJavaStaticField(env, classId, fieldId, value.getInstance());
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const jobject& value)
+{
+    env->SetObjectField(objId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const double& value)
+{
+    env->SetDoubleField(objId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const long& value)
+{
+    env->SetLongField(objId, fieldId, (jlong)value);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const jlong& value)
+{
+    env->SetLongField(objId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const float& value)
+{
+    env->SetFloatField(objId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const int& value)
+{
+    env->SetIntField(objId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const bool& value)
+{
+    env->SetBooleanField(objId, fieldId, value);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const std::string& value)
+{
+    jobject obj = createJavaString(env, value);
+    setJavaField(env, objId, fieldId, obj);
+    env->DeleteLocalRef(obj);
+}
+ 
+template<>
+void JniObject::setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const JniObject& value)
+{
+    setJavaField(env, objId, fieldId, value.getInstance());
 }
  
 template<>
@@ -933,11 +2522,41 @@ jarray JniObject::createJavaArray(JNIEnv* env, const float& element, size_t size
 }
  
 template<>
-jarray JniObject::createJavaArray(JNIEnv* env, const int& element, size_t size)
+jarray JniObject::createJavaArray(JNIEnv* env, const long long& element, size_t size)
 {
     return env->NewLongArray(size);
 }
 
+template<>
+jarray JniObject::createJavaArray(JNIEnv* env, const int& element, size_t size)
+{
+    return env->NewIntArray(size);
+}
+
+template<>
+jarray JniObject::createJavaArray(JNIEnv* env, const unsigned int& element, size_t size)
+{
+    return env->NewIntArray(size);
+}
+
+template<>
+jarray JniObject::createJavaArray(JNIEnv* env, const short& element, size_t size)
+{
+    return env->NewShortArray(size);
+}
+
+template<>
+jarray JniObject::createJavaArray(JNIEnv* env, const char& element, size_t size)
+{
+    return env->NewCharArray(size);
+}
+
+template<>
+jarray JniObject::createJavaArray(JNIEnv* env, const bool& element, size_t size)
+{
+    return env->NewBooleanArray(size);
+}
+
 template<>
 jarray JniObject::createJavaArray(JNIEnv* env, const uint8_t& element, size_t size)
 {
@@ -1013,6 +2632,7 @@ bool JniObject::convertFromJavaArrayElement(JNIEnv* env, jarray arr, size_t posi
         return false;
     }
     convertFromJavaObject(env, obj, out);
+    env->DeleteLocalRef(obj);
     return true;
 }
  
@@ -1068,8 +2688,9 @@ void JniObject::setJavaArrayElement(JNIEnv* env, jarray arr, size_t position, co
 template<>
 void JniObject::setJavaArrayElement(JNIEnv* env, jarray arr, size_t position, const std::string& elm)
 {
-    jobject obj = env->NewStringUTF(elm.c_str());
+    jobject obj = createJavaString(env, elm);
     setJavaArrayElement(env, arr, position, obj);
+    env->DeleteLocalRef(obj);
 }
  
 template<>
@@ -1077,67 +2698,3 @@ void JniObject::setJavaArrayElement(JNIEnv* env, jarray arr, size_t position, co
 {
     setJavaArrayElement(env, arr, position, elm.getInstance());
 }
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<double>& obj)
-{
-    env->SetDoubleArrayRegion((jdoubleArray)arr, 0, obj.size(), obj.data());
-}
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<long>& obj)
-{
-    env->SetLongArrayRegion((jlongArray)arr, 0, obj.size(), (const jlong*)obj.data());
-}
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<float>& obj)
-{
-    env->SetFloatArrayRegion((jfloatArray)arr, 0, obj.size(), obj.data());
-}
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<int>& obj)
-{
-    env->SetIntArrayRegion((jintArray)arr, 0, obj.size(), obj.data());
-}
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<uint8_t>& obj)
-{
-    env->SetByteArrayRegion((jbyteArray)arr, 0, obj.size(), (const jbyte*)obj.data());
-}
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<JniObject>& obj)
-{
-    size_t i = 0;
-    for(auto itr = obj.begin(); itr != obj.end(); ++itr)
-    {
-        setJavaArrayElement(env, arr, i, *itr);
-        i++;
-    }
-}
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<std::string>& obj)
-{
-    size_t i = 0;
-    for(auto itr = obj.begin(); itr != obj.end(); ++itr)
-    {
-        setJavaArrayElement(env, arr, i, *itr);
-        i++;
-    }
-}
-
-template<>
-void JniObject::setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<jobject>& obj)
-{
-    size_t i = 0;
-    for(auto itr = obj.begin(); itr != obj.end(); ++itr)
-    {
-        setJavaArrayElement(env, arr, i, *itr);
-        i++;
-    }
-}
-
@@ -6,10 +6,22 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
 #include <array>
 #include <list>
 #include <set>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <future>
+#include <type_traits>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <exception>
 #include <android/log.h>
 
@@ -29,19 +41,115 @@ public:
     }
 };
  
+/**
+ * A java string interned with Jni::intern
+ * It is passed to java calls as is, without converting it again
+ */
+class JniString
+{
+private:
+    jstring _instance;
+public:
+    explicit JniString(jstring instance=nullptr):
+    _instance(instance)
+    {
+    }
+
+    /**
+     * Returns the jstring reference. This is a global ref owned by Jni
+     */
+    jstring getInstance() const
+    {
+        return _instance;
+    }
+
+    operator bool() const
+    {
+        return _instance != nullptr;
+    }
+};
+
+class JniWorkerPool;
+
 class Jni
 {
 private:
-    typedef std::map<std::string, jclass> ClassMap;
+    struct ClassEntry
+    {
+        std::string classPath;
+        jclass classId;
+    };
+    typedef std::unordered_map<size_t, std::vector<ClassEntry>> ClassMap;
+    typedef std::unordered_map<jint, std::vector<ClassEntry>> ClassPathMap;
+    enum class SingletonAccess
+    {
+        Unknown,
+        Field,
+        Method,
+        Missing
+    };
+    struct SingletonEntry
+    {
+        jobject instance;
+        SingletonAccess access;
+    };
+
+    /**
+     * Method or field ids by class, name and signature
+     * Like the class cache it is made of immutable snapshots, the ids of
+     * a class are copied when one is added and the class table only when
+     * a class is added. Replaced snapshots are kept until Jni is destroyed
+     */
+    template<typename Id>
+    class IdCache
+    {
+    private:
+        typedef std::unordered_map<std::string, std::unordered_map<std::string, Id>> Ids;
+        typedef std::unordered_map<jclass, const Ids*> ClassIds;
+        std::atomic<const ClassIds*> _classes;
+        std::vector<std::unique_ptr<const ClassIds>> _classSnapshots;
+        std::vector<std::unique_ptr<const Ids>> _idSnapshots;
+        std::mutex _mutex;
+    public:
+        IdCache();
+        bool find(jclass classId, const std::string& name, const std::string& signature, Id& out) const;
+        void add(jclass classId, const std::string& name, const std::string& signature, Id id);
+    };
     static JavaVM* _java;
-    static JNIEnv* _env;
     static int _thread;
-    ClassMap _classes;
+    static thread_local JNIEnv* _threadEnv;
+    std::atomic<const ClassMap*> _classes;
+    std::vector<std::unique_ptr<const ClassMap>> _classSnapshots;
+    std::mutex _classesMutex;
+    std::atomic<const ClassPathMap*> _classPaths;
+    std::vector<std::unique_ptr<const ClassPathMap>> _classPathSnapshots;
+    std::mutex _classPathsMutex;
+    jclass _systemClass;
+    jmethodID _identityHashCode;
+    IdCache<jmethodID> _methods;
+    IdCache<jmethodID> _staticMethods;
+    IdCache<jfieldID> _fields;
+    IdCache<jfieldID> _staticFields;
+    std::atomic<unsigned long> _methodHits;
+    std::atomic<unsigned long> _methodMisses;
+    std::unordered_map<std::string, jstring> _strings;
+    std::mutex _stringsMutex;
+    std::unordered_map<std::string, SingletonEntry> _singletons;
+    std::mutex _singletonsMutex;
+    std::unique_ptr<JniWorkerPool> _workers;
+    std::mutex _workersMutex;
  
     Jni();
     Jni(const Jni& other);
 
     static void detachCurrentThread(void*);
+    static const ClassEntry* findCachedClass(const ClassMap& classes, const std::string& classPath, size_t classHash);
+
+    /**
+     * Add a class or a miss if it is null to the class cache
+     * returns the class that is cached for the path
+     */
+    jclass addClass(JNIEnv* env, const std::string& classPath, size_t classHash, jclass classId);
 public:
     ~Jni();
  
@@ -63,464 +171,2430 @@ public:
     /**
      * Get the java environment pointer
      * Will attatch to the current thread automatically
+     * and detach it when the thread exits
+     */
+    static JNIEnv* getEnvironment();
+
+    /**
+     * Attach the current thread with a java thread name
+     * it is not detached when the thread exits, call detachThread
+     */
+    static JNIEnv* attachThread(const std::string& name, bool daemon=true);
+
+    /**
+     * Detach a thread attached with attachThread
+     */
+    static void detachThread();
+
+    /**
+     * Get the pool of attached worker threads
+     * it is started with one thread per core on first use
      */
-    JNIEnv* getEnvironment();
+    JniWorkerPool& getWorkers();
  
     /**
      * get a class, will be stored in the class cache
+     * the cache is an immutable snapshot that is replaced when a class is added,
+     * lookups only do an atomic load. Classes are never removed, so the
+     * replaced snapshots are kept until Jni is destroyed.
+     * A class FindClass can not find is cached as missing; on threads
+     * attached from native code it only sees the system classes, app
+     * classes are then learned through registerClass
      */
     jclass getClass(const std::string& classPath, bool cache=true);
 
+    /**
+     * get a class using a hash obtained with getClassHash
+     */
+    jclass getClass(const std::string& classPath, size_t classHash, bool cache=true);
+
+    /**
+     * Add a class found through an object to the class cache
+     * returns the class already cached for the path if there is one
+     */
+    jclass registerClass(const std::string& classPath, jclass classId);
+
+    /**
+     * Return the hash used to look up a class path in the class cache
+     */
+    static size_t getClassHash(const std::string& classPath);
+
+    /**
+     * get the class path of a class, will be stored in the class path cache
+     * refs to the same class can differ, so the cache is bucketed by
+     * System.identityHashCode and compared with IsSameObject in a bucket.
+     * A cached lookup still costs those two jni calls
+     */
+    std::string getClassPath(jclass classId);
+
+    /**
+     * get a method id, will be stored in the method cache
+     * the class should be one returned by getClass so that it stays valid,
+     * lookups do not lock
+     */
+    jmethodID getMethodId(jclass classId, const std::string& name, const std::string& signature, bool isStatic=false);
+
+    /**
+     * get a field id, will be stored in the field cache
+     * the class should be one returned by getClass so that it stays valid
+     */
+    jfieldID getFieldId(jclass classId, const std::string& name, const std::string& signature, bool isStatic=false);
+
+    /**
+     * Number of method id lookups served from the cache
+     */
+    unsigned long getMethodCacheHits() const;
+
+    /**
+     * Number of method id lookups that had to go to the vm
+     */
+    unsigned long getMethodCacheMisses() const;
+
+    /**
+     * Get a java string that is only created once per value
+     * The string is kept as a global ref until Jni is destroyed,
+     * so only use it for a limited set of constant values
+     */
+    JniString intern(const std::string& value);
+
+    /**
+     * Get the singleton instance of a class, will be stored in the singleton cache
+     * tries the `instance` static field and a `getInstance` static method
+     * and remembers which one to use. A null instance is read again next
+     * time, a class with neither is remembered until it is invalidated.
+     * Returns a new local ref
+     */
+    jobject getSingleton(const std::string& classPath);
+
+    /**
+     * Remove a singleton instance from the cache, all of them if the
+     * class path is empty. Call it when java replaces the instance
+     */
+    void invalidateSingleton(const std::string& classPath="");
+
 };
  
 /**
- * This class represents a jni object
+ * Worker threads that stay attached to the java vm
+ * Tasks are queued on the workers in turn, idle workers steal
+ * tasks from the back of the other queues. Every task runs in its own
+ * local frame since the workers never return to java to free local refs.
+ * A worker that can not attach stops, its queued tasks go to the others.
  */
-class JniObject
+class JniWorkerPool
 {
+public:
+    typedef std::function<void(JNIEnv*)> Task;
 private:
- 
-    jclass _class;
-    jobject _instance;
-    mutable std::string _classPath;
+    struct Worker
+    {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+        std::thread thread;
+        bool attached;
+    };
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    size_t _pending;
+    size_t _attached;
+    bool _stopped;
+    std::atomic<size_t> _next;
 
-    static void checkJniException();
+    JniWorkerPool(const JniWorkerPool& other) = delete;
+    JniWorkerPool& operator=(const JniWorkerPool& other) = delete;
+
+    bool popTask(size_t index, Task& task);
+    void run(size_t index, const std::string& name);
+    void stopWorker(size_t index);
+public:
+    JniWorkerPool(size_t count, const std::string& name="JniWorker");
+
+    /**
+     * Runs the queued tasks and stops the workers
+     */
+    ~JniWorkerPool();
+
+    /**
+     * Queue a task, it gets the environment of the worker that runs it
+     * Exceptions thrown by the task are dropped
+     * Throws a JniException if no worker could attach
+     */
+    void post(Task task);
+
+    size_t size() const;
+};
+
+/**
+ * Compile time jni signatures
+ * JniSignatureType<Type>::type is only defined for types whose
+ * signature does not depend on the runtime value (objects do)
+ */
+template<char... Chars>
+struct JniSignatureChars
+{
+    static const char value[sizeof...(Chars)+1];
+};
+
+template<char... Chars>
+const char JniSignatureChars<Chars...>::value[sizeof...(Chars)+1] = {Chars..., '\0'};
+
+template<typename First, typename Second>
+struct JniSignatureJoin;
+
+template<char... First, char... Second>
+struct JniSignatureJoin<JniSignatureChars<First...>, JniSignatureChars<Second...>>
+{
+    typedef JniSignatureChars<First..., Second...> type;
+};
+
+template<typename... Parts>
+struct JniSignatureConcat
+{
+    typedef JniSignatureChars<> type;
+};
+
+template<typename Part, typename... Parts>
+struct JniSignatureConcat<Part, Parts...>
+{
+    typedef typename JniSignatureJoin<Part, typename JniSignatureConcat<Parts...>::type>::type type;
+};
+
+template<typename Type, typename Enable=void>
+struct JniSignatureType
+{
+};
+
+template<typename Type>
+struct JniHasStaticSignature
+{
+private:
+    template<typename Test>
+    static char test(typename JniSignatureType<Test>::type*);
+    template<typename Test>
+    static long test(...);
+public:
+    static const bool value = sizeof(test<Type>(nullptr)) == sizeof(char);
+};
+
+template<typename... Types>
+struct JniHasStaticSignatures : std::true_type
+{
+};
+
+template<typename Type, typename... Types>
+struct JniHasStaticSignatures<Type, Types...> : std::integral_constant<bool,
+    JniHasStaticSignature<Type>::value && JniHasStaticSignatures<Types...>::value>
+{
+};
+
+template<> struct JniSignatureType<void> { typedef JniSignatureChars<'V'> type; };
+template<> struct JniSignatureType<bool> { typedef JniSignatureChars<'Z'> type; };
+template<> struct JniSignatureType<uint8_t> { typedef JniSignatureChars<'B'> type; };
+template<> struct JniSignatureType<char> { typedef JniSignatureChars<'C'> type; };
+template<> struct JniSignatureType<short> { typedef JniSignatureChars<'S'> type; };
+template<> struct JniSignatureType<int> { typedef JniSignatureChars<'I'> type; };
+template<> struct JniSignatureType<unsigned int> { typedef JniSignatureChars<'I'> type; };
+template<> struct JniSignatureType<long> { typedef JniSignatureChars<'J'> type; };
+template<> struct JniSignatureType<long long> { typedef JniSignatureChars<'J'> type; };
+template<> struct JniSignatureType<float> { typedef JniSignatureChars<'F'> type; };
+template<> struct JniSignatureType<double> { typedef JniSignatureChars<'D'> type; };
+
+template<>
+struct JniSignatureType<std::string>
+{
+    typedef JniSignatureChars<'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'S', 't', 'r', 'i', 'n', 'g', ';'> type;
+};
+
+// pointers are passed as longs, java references are resolved at runtime
+template<typename Type>
+struct JniSignatureType<Type*, typename std::enable_if<!std::is_convertible<Type*, jobject>::value>::type>
+{
+    typedef JniSignatureChars<'J'> type;
+};
+
+template<>
+struct JniSignatureType<JniString> : JniSignatureType<std::string>
+{
+};
+
+template<typename Type, typename Enable=void>
+struct JniSignatureArrayType
+{
+};
+
+template<typename Type>
+struct JniSignatureArrayType<Type, typename std::enable_if<JniHasStaticSignature<Type>::value>::type>
+{
+    typedef typename JniSignatureJoin<JniSignatureChars<'['>, typename JniSignatureType<Type>::type>::type type;
+};
+
+template<typename Type>
+struct JniSignatureType<std::vector<Type>> : JniSignatureArrayType<Type> {};
+template<typename Type>
+struct JniSignatureType<std::set<Type>> : JniSignatureArrayType<Type> {};
+template<typename Type, size_t Size>
+struct JniSignatureType<std::array<Type, Size>> : JniSignatureArrayType<Type> {};
+template<typename Type>
+struct JniSignatureType<std::list<Type>> : JniSignatureArrayType<Type> {};
+
+template<typename Key, typename Value>
+struct JniSignatureType<std::map<Key, Value>>
+{
+    typedef JniSignatureChars<'L', 'j', 'a', 'v', 'a', '/', 'u', 't', 'i', 'l', '/', 'M', 'a', 'p', ';'> type;
+};
+
+/**
+ * Arguments that are converted to a new local ref when calling
+ * and need to be deleted afterwards
+ */
+template<typename Type>
+struct JniIsObjectArgument : std::false_type {};
+template<>
+struct JniIsObjectArgument<std::string> : std::true_type {};
+template<typename Type>
+struct JniIsObjectArgument<std::vector<Type>> : std::true_type {};
+template<typename Type>
+struct JniIsObjectArgument<std::set<Type>> : std::true_type {};
+template<typename Type, size_t Size>
+struct JniIsObjectArgument<std::array<Type, Size>> : std::true_type {};
+template<typename Type>
+struct JniIsObjectArgument<std::list<Type>> : std::true_type {};
+template<typename Key, typename Value>
+struct JniIsObjectArgument<std::map<Key, Value>> : std::true_type {};
+
+/**
+ * The method signature of a Return(Args...) call
+ */
+template<typename Return, typename... Args>
+struct JniSignature
+{
+    typedef typename JniSignatureConcat<JniSignatureChars<'('>,
+        typename JniSignatureType<Args>::type...,
+        JniSignatureChars<')'>,
+        typename JniSignatureType<Return>::type>::type type;
+};
  
-    template<typename Arg, typename... Args>
-    static void buildSignature(std::ostringstream& os, const Arg& arg, const Args&... args)
+/**
+ * Bulk access to java primitive arrays
+ * direct is true if the c++ storage can be handed to jni as is,
+ * otherwise the elements are converted through a buffer
+ */
+template<typename Type>
+struct JniPrimitiveArrayRegion
+{
+};
+
+template<>
+struct JniPrimitiveArrayRegion<jboolean>
+{
+    typedef jboolean type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
     {
-        os << getSignaturePart(arg);
-        buildSignature(os, args...);
+        env->GetBooleanArrayRegion((jbooleanArray)arr, start, len, buf);
     }
- 
-    static void buildSignature(std::ostringstream& os)
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
     {
+        env->SetBooleanArrayRegion((jbooleanArray)arr, start, len, buf);
     }
- 
-    template<typename Return, typename... Args>
-    static std::string createSignature(const Return& ret, const Args&... args)
+    static type* getElements(JNIEnv* env, jarray arr)
     {
-        std::ostringstream os;
-        os << "(";
-        buildSignature(os, args...);
-        os << ")" << getSignaturePart(ret);
-        return os.str();
+        return env->GetBooleanArrayElements((jbooleanArray)arr, nullptr);
     }
- 
-    template<typename... Args>
-    static std::string createVoidSignature(const Args&... args)
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
     {
-        std::ostringstream os;
-        os << "(";
-        buildSignature(os, args...);
-        os << ")" << getSignaturePart();
-        return os.str();
+        env->ReleaseBooleanArrayElements((jbooleanArray)arr, elms, mode);
     }
- 
-    template<typename... Args>
-    static jvalue* createArguments(const Args&... args)
+};
+
+template<>
+struct JniPrimitiveArrayRegion<jbyte>
+{
+    typedef jbyte type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
     {
-        jvalue* jargs = (jvalue*)malloc(sizeof(jvalue)*sizeof...(Args));
-        buildArguments(jargs, 0, args...);
-        return jargs;
+        env->GetByteArrayRegion((jbyteArray)arr, start, len, buf);
     }
- 
-    static jvalue* createArguments()
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
     {
-        return nullptr;
+        env->SetByteArrayRegion((jbyteArray)arr, start, len, buf);
     }
- 
-    template<typename Arg, typename... Args>
-    static void buildArguments(jvalue* jargs, unsigned pos, const Arg& arg, const Args&... args)
+    static type* getElements(JNIEnv* env, jarray arr)
     {
-        jargs[pos] = convertToJavaValue(arg);
-        buildArguments(jargs, pos+1, args...);
-        
+        return env->GetByteArrayElements((jbyteArray)arr, nullptr);
     }
- 
-    static void buildArguments(jvalue* jargs, unsigned pos)
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
     {
+        env->ReleaseByteArrayElements((jbyteArray)arr, elms, mode);
     }
+};
 
-template<typename... Args>
-    static void findObjectArguments(std::vector<jobject*>& jobjs, jvalue* jargs, const Args&... args)
+template<>
+struct JniPrimitiveArrayRegion<jchar>
+{
+    typedef jchar type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
+    {
+        env->GetCharArrayRegion((jcharArray)arr, start, len, buf);
+    }
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
+    {
+        env->SetCharArrayRegion((jcharArray)arr, start, len, buf);
+    }
+    static type* getElements(JNIEnv* env, jarray arr)
+    {
+        return env->GetCharArrayElements((jcharArray)arr, nullptr);
+    }
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
     {
-        processObjectArguments(jobjs, jargs, 0, args...);
+        env->ReleaseCharArrayElements((jcharArray)arr, elms, mode);
     }
+};
 
-    template<typename Arg, typename... Args>
-    static void processObjectArguments(std::vector<jobject*>& jobjs, jvalue* jargs, unsigned pos, const Arg& arg, const Args&... args)
+template<>
+struct JniPrimitiveArrayRegion<jshort>
+{
+    typedef jshort type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
     {
-        if(isObjectArgument(arg))
-        {
-            jobjs.push_back(&jargs[pos].l);
-        }
+        env->GetShortArrayRegion((jshortArray)arr, start, len, buf);
+    }
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
+    {
+        env->SetShortArrayRegion((jshortArray)arr, start, len, buf);
+    }
+    static type* getElements(JNIEnv* env, jarray arr)
+    {
+        return env->GetShortArrayElements((jshortArray)arr, nullptr);
+    }
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
+    {
+        env->ReleaseShortArrayElements((jshortArray)arr, elms, mode);
+    }
+};
 
-        processObjectArguments(jobjs, jargs, pos+1, args...);
+template<>
+struct JniPrimitiveArrayRegion<jint>
+{
+    typedef jint type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
+    {
+        env->GetIntArrayRegion((jintArray)arr, start, len, buf);
     }
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
+    {
+        env->SetIntArrayRegion((jintArray)arr, start, len, buf);
+    }
+    static type* getElements(JNIEnv* env, jarray arr)
+    {
+        return env->GetIntArrayElements((jintArray)arr, nullptr);
+    }
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
+    {
+        env->ReleaseIntArrayElements((jintArray)arr, elms, mode);
+    }
+};
 
-    static void processObjectArguments(std::vector<jobject*>& jobjs, jvalue* jargs, unsigned pos)
+template<>
+struct JniPrimitiveArrayRegion<jlong>
+{
+    typedef jlong type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
     {
+        env->GetLongArrayRegion((jlongArray)arr, start, len, buf);
     }
-    
-    /**
-     * Return the signature for the given type
-     */
-    template<typename Type>
-    static std::string getSignaturePart(const Type& type);
- 
-    /**
-    * Return the signature for the given container element
-    */
-    template<typename Type>
-    static std::string getContainerElementSignaturePart(const Type& container)
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
     {
-        if(container.empty())
-        {
-            return getSignaturePart(typename Type::value_type());
-        }
-        else
-        {
-            return getSignaturePart(*container.begin());
-        }
+        env->SetLongArrayRegion((jlongArray)arr, start, len, buf);
     }
- 
-    // template specialization for pointers
-    template<typename Type>
-    static std::string getSignaturePart(Type* val)
+    static type* getElements(JNIEnv* env, jarray arr)
     {
-        return getSignaturePart((jlong)val);
+        return env->GetLongArrayElements((jlongArray)arr, nullptr);
     }
- 
-    // template specialization for containers
-    template<typename Type>
-    static std::string getSignaturePart(const std::vector<Type>& val)
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
     {
-        return std::string("[")+getContainerElementSignaturePart(val);
+        env->ReleaseLongArrayElements((jlongArray)arr, elms, mode);
     }
-    template<typename Type>
-    static std::string getSignaturePart(const std::set<Type>& val)
+};
+
+template<>
+struct JniPrimitiveArrayRegion<jfloat>
+{
+    typedef jfloat type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
     {
-        return std::string("[")+getContainerElementSignaturePart(val);
+        env->GetFloatArrayRegion((jfloatArray)arr, start, len, buf);
     }
-    template<typename Type, int Size>
-    static std::string getSignaturePart(const std::array<Type, Size>& val)
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
     {
-        return std::string("[")+getContainerElementSignaturePart(val);
+        env->SetFloatArrayRegion((jfloatArray)arr, start, len, buf);
     }
-    template<typename Type>
-    static std::string getSignaturePart(const std::list<Type>& val)
+    static type* getElements(JNIEnv* env, jarray arr)
+    {
+        return env->GetFloatArrayElements((jfloatArray)arr, nullptr);
+    }
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
+    {
+        env->ReleaseFloatArrayElements((jfloatArray)arr, elms, mode);
+    }
+};
+
+template<>
+struct JniPrimitiveArrayRegion<jdouble>
+{
+    typedef jdouble type;
+    static void getRegion(JNIEnv* env, jarray arr, jsize start, jsize len, type* buf)
+    {
+        env->GetDoubleArrayRegion((jdoubleArray)arr, start, len, buf);
+    }
+    static void setRegion(JNIEnv* env, jarray arr, jsize start, jsize len, const type* buf)
+    {
+        env->SetDoubleArrayRegion((jdoubleArray)arr, start, len, buf);
+    }
+    static type* getElements(JNIEnv* env, jarray arr)
+    {
+        return env->GetDoubleArrayElements((jdoubleArray)arr, nullptr);
+    }
+    static void releaseElements(JNIEnv* env, jarray arr, type* elms, jint mode)
+    {
+        env->ReleaseDoubleArrayElements((jdoubleArray)arr, elms, mode);
+    }
+};
+
+template<typename Type>
+struct JniPrimitiveArray
+{
+};
+
+template<>
+struct JniPrimitiveArray<bool> : JniPrimitiveArrayRegion<jboolean>
+{
+    static const bool direct = false;
+};
+
+template<>
+struct JniPrimitiveArray<uint8_t> : JniPrimitiveArrayRegion<jbyte>
+{
+    static const bool direct = true;
+};
+
+template<>
+struct JniPrimitiveArray<char> : JniPrimitiveArrayRegion<jchar>
+{
+    static const bool direct = false;
+};
+
+template<>
+struct JniPrimitiveArray<short> : JniPrimitiveArrayRegion<jshort>
+{
+    static const bool direct = true;
+};
+
+template<>
+struct JniPrimitiveArray<int> : JniPrimitiveArrayRegion<jint>
+{
+    static const bool direct = true;
+};
+
+template<>
+struct JniPrimitiveArray<unsigned int> : JniPrimitiveArrayRegion<jint>
+{
+    static const bool direct = true;
+};
+
+template<>
+struct JniPrimitiveArray<long> : JniPrimitiveArrayRegion<jlong>
+{
+    static const bool direct = std::is_same<long, jlong>::value;
+};
+
+template<>
+struct JniPrimitiveArray<long long> : JniPrimitiveArrayRegion<jlong>
+{
+    static const bool direct = std::is_same<long long, jlong>::value;
+};
+
+template<>
+struct JniPrimitiveArray<float> : JniPrimitiveArrayRegion<jfloat>
+{
+    static const bool direct = true;
+};
+
+template<>
+struct JniPrimitiveArray<double> : JniPrimitiveArrayRegion<jdouble>
+{
+    static const bool direct = true;
+};
+
+template<typename Type>
+struct JniIsPrimitive
+{
+private:
+    template<typename Test>
+    static char test(typename JniPrimitiveArray<Test>::type*);
+    template<typename Test>
+    static long test(...);
+public:
+    static const bool value = sizeof(test<Type>(nullptr)) == sizeof(char);
+};
+
+/**
+ * Results that jni returns directly, other results are converted from a jobject
+ */
+template<typename Type>
+struct JniIsDirectResult : std::integral_constant<bool,
+    JniIsPrimitive<Type>::value || std::is_same<Type, jobject>::value>
+{
+};
+
+/**
+ * A non owning view over contiguous native memory
+ */
+template<typename Type>
+class JniSpan
+{
+private:
+    Type* _data;
+    size_t _size;
+public:
+    JniSpan(Type* data=nullptr, size_t size=0):
+    _data(data), _size(size)
+    {
+    }
+
+    Type* data() const
+    {
+        return _data;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    Type* begin() const
+    {
+        return _data;
+    }
+
+    Type* end() const
+    {
+        return _data+_size;
+    }
+
+    Type& operator[](size_t pos) const
+    {
+        return _data[pos];
+    }
+};
+
+/**
+ * The java wrapper classes used to box primitives
+ */
+template<typename Type>
+struct JniBoxed
+{
+};
+
+template<>
+struct JniBoxed<bool>
+{
+    static const char* classPath() { return "java/lang/Boolean"; }
+    static const char* valueOfSignature() { return "(Z)Ljava/lang/Boolean;"; }
+    static const char* valueName() { return "booleanValue"; }
+    static const char* valueSignature() { return "()Z"; }
+    static bool unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallBooleanMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<uint8_t>
+{
+    static const char* classPath() { return "java/lang/Byte"; }
+    static const char* valueOfSignature() { return "(B)Ljava/lang/Byte;"; }
+    static const char* valueName() { return "byteValue"; }
+    static const char* valueSignature() { return "()B"; }
+    static uint8_t unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallByteMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<char>
+{
+    static const char* classPath() { return "java/lang/Character"; }
+    static const char* valueOfSignature() { return "(C)Ljava/lang/Character;"; }
+    static const char* valueName() { return "charValue"; }
+    static const char* valueSignature() { return "()C"; }
+    static char unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallCharMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<short>
+{
+    static const char* classPath() { return "java/lang/Short"; }
+    static const char* valueOfSignature() { return "(S)Ljava/lang/Short;"; }
+    static const char* valueName() { return "shortValue"; }
+    static const char* valueSignature() { return "()S"; }
+    static short unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallShortMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<int>
+{
+    static const char* classPath() { return "java/lang/Integer"; }
+    static const char* valueOfSignature() { return "(I)Ljava/lang/Integer;"; }
+    static const char* valueName() { return "intValue"; }
+    static const char* valueSignature() { return "()I"; }
+    static int unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallIntMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<unsigned int>
+{
+    static const char* classPath() { return "java/lang/Integer"; }
+    static const char* valueOfSignature() { return "(I)Ljava/lang/Integer;"; }
+    static const char* valueName() { return "intValue"; }
+    static const char* valueSignature() { return "()I"; }
+    static unsigned int unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallIntMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<long>
+{
+    static const char* classPath() { return "java/lang/Long"; }
+    static const char* valueOfSignature() { return "(J)Ljava/lang/Long;"; }
+    static const char* valueName() { return "longValue"; }
+    static const char* valueSignature() { return "()J"; }
+    static long unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallLongMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<long long>
+{
+    static const char* classPath() { return "java/lang/Long"; }
+    static const char* valueOfSignature() { return "(J)Ljava/lang/Long;"; }
+    static const char* valueName() { return "longValue"; }
+    static const char* valueSignature() { return "()J"; }
+    static long long unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallLongMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<float>
+{
+    static const char* classPath() { return "java/lang/Float"; }
+    static const char* valueOfSignature() { return "(F)Ljava/lang/Float;"; }
+    static const char* valueName() { return "floatValue"; }
+    static const char* valueSignature() { return "()F"; }
+    static float unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallFloatMethodA(obj, methodId, nullptr); }
+};
+
+template<>
+struct JniBoxed<double>
+{
+    static const char* classPath() { return "java/lang/Double"; }
+    static const char* valueOfSignature() { return "(D)Ljava/lang/Double;"; }
+    static const char* valueName() { return "doubleValue"; }
+    static const char* valueSignature() { return "()D"; }
+    static double unbox(JNIEnv* env, jobject obj, jmethodID methodId) { return env->CallDoubleMethodA(obj, methodId, nullptr); }
+};
+
+template<typename Type>
+struct JniIsBoxed
+{
+private:
+    template<typename Test>
+    static char test(decltype(&JniBoxed<Test>::classPath));
+    template<typename Test>
+    static long test(...);
+public:
+    static const bool value = sizeof(test<Type>(nullptr)) == sizeof(char);
+};
+
+/**
+ * The java stream that boxes a whole primitive array
+ * Only int, long and double arrays have one
+ */
+template<typename Type>
+struct JniBoxedStream
+{
+};
+
+template<>
+struct JniBoxedStream<jint>
+{
+    static const char* classPath() { return "java/util/stream/IntStream"; }
+    static const char* streamSignature() { return "([I)Ljava/util/stream/IntStream;"; }
+};
+
+template<>
+struct JniBoxedStream<jlong>
+{
+    static const char* classPath() { return "java/util/stream/LongStream"; }
+    static const char* streamSignature() { return "([J)Ljava/util/stream/LongStream;"; }
+};
+
+template<>
+struct JniBoxedStream<jdouble>
+{
+    static const char* classPath() { return "java/util/stream/DoubleStream"; }
+    static const char* streamSignature() { return "([D)Ljava/util/stream/DoubleStream;"; }
+};
+
+template<typename Type, typename Enable=void>
+struct JniHasBoxedStream : std::false_type
+{
+};
+
+template<typename Type>
+struct JniHasBoxedStream<Type, typename std::enable_if<JniIsPrimitive<Type>::value>::type>
+{
+private:
+    template<typename Test>
+    static char test(decltype(&JniBoxedStream<Test>::classPath));
+    template<typename Test>
+    static long test(...);
+public:
+    static const bool value = sizeof(test<typename JniPrimitiveArray<Type>::type>(nullptr)) == sizeof(char);
+};
+
+/**
+ * How JniArrayElements accesses a java array
+ * Critical pins the array, no other jni calls are allowed until it is released
+ * ReadOnly and ReadWrite may get a copy, ReadOnly discards it on release
+ */
+enum class JniArrayAccess
+{
+    Critical,
+    CriticalReadOnly,
+    ReadOnly,
+    ReadWrite
+};
+
+/**
+ * Scoped access to the elements of a java primitive array
+ * The array is released when it goes out of scope
+ */
+template<typename Type>
+class JniArrayElements
+{
+private:
+    static_assert(JniPrimitiveArray<Type>::direct, "type has to match the jni array layout");
+    typedef JniPrimitiveArray<Type> Array;
+
+    JNIEnv* _env;
+    jarray _array;
+    JniArrayAccess _access;
+    Type* _data;
+    size_t _size;
+
+    JniArrayElements(const JniArrayElements& other) = delete;
+    JniArrayElements& operator=(const JniArrayElements& other) = delete;
+public:
+    JniArrayElements(JNIEnv* env, jarray arr, JniArrayAccess access=JniArrayAccess::ReadOnly):
+    _env(env), _array(arr), _access(access), _data(nullptr), _size(0)
+    {
+        if(!_env || !_array)
+        {
+            return;
+        }
+        _size = _env->GetArrayLength(_array);
+        if(_access == JniArrayAccess::Critical || _access == JniArrayAccess::CriticalReadOnly)
+        {
+            _data = static_cast<Type*>(_env->GetPrimitiveArrayCritical(_array, nullptr));
+        }
+        else
+        {
+            _data = reinterpret_cast<Type*>(Array::getElements(_env, _array));
+        }
+        if(!_data)
+        {
+            _size = 0;
+        }
+    }
+
+    JniArrayElements(jarray arr, JniArrayAccess access=JniArrayAccess::ReadOnly):
+    JniArrayElements(Jni::get().getEnvironment(), arr, access)
+    {
+    }
+
+    JniArrayElements(JniArrayElements&& other):
+    _env(other._env), _array(other._array), _access(other._access), _data(other._data), _size(other._size)
+    {
+        other._data = nullptr;
+        other._size = 0;
+    }
+
+    ~JniArrayElements()
+    {
+        release();
+    }
+
+    /**
+     * Release the array before going out of scope
+     */
+    void release()
+    {
+        if(!_data)
+        {
+            return;
+        }
+        switch(_access)
+        {
+        case JniArrayAccess::Critical:
+            _env->ReleasePrimitiveArrayCritical(_array, _data, 0);
+            break;
+        case JniArrayAccess::CriticalReadOnly:
+            _env->ReleasePrimitiveArrayCritical(_array, _data, JNI_ABORT);
+            break;
+        case JniArrayAccess::ReadOnly:
+            Array::releaseElements(_env, _array, reinterpret_cast<typename Array::type*>(_data), JNI_ABORT);
+            break;
+        case JniArrayAccess::ReadWrite:
+            Array::releaseElements(_env, _array, reinterpret_cast<typename Array::type*>(_data), 0);
+            break;
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+
+    JniSpan<Type> getSpan() const
+    {
+        return JniSpan<Type>(_data, _size);
+    }
+
+    Type* data() const
+    {
+        return _data;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    operator bool() const
+    {
+        return _data != nullptr;
+    }
+};
+
+/**
+ * Scoped local reference frame
+ * Loops that create local refs per element call step() on every iteration,
+ * the frame is popped and pushed again every chunk iterations
+ * so the number of live local refs stays bounded.
+ */
+class JniLocalFrame
+{
+private:
+    JNIEnv* _env;
+    jint _chunk;
+    jint _count;
+    bool _pushed;
+
+    JniLocalFrame(const JniLocalFrame& other) = delete;
+    JniLocalFrame& operator=(const JniLocalFrame& other) = delete;
+
+    void push();
+public:
+    static const jint DefaultChunk = 32;
+
+    /**
+     * An inactive frame does nothing, it is used by loops whose results are local refs
+     * Throws a JniException if the frame can not be pushed
+     */
+    JniLocalFrame(JNIEnv* env, jint chunk=DefaultChunk, bool active=true);
+    ~JniLocalFrame();
+
+    /**
+     * Count an iteration, will renew the frame if the chunk is full
+     */
+    void step();
+
+    /**
+     * Release all the local refs created in the frame
+     */
+    void renew();
+
+    /**
+     * Pop the frame, the result is returned as a local ref of the outer frame
+     */
+    jobject pop(jobject result=nullptr);
+};
+
+template<typename Signature>
+class JniMethod;
+
+template<typename Signature>
+class JniStaticMethod;
+
+template<typename... Args>
+class JniConstructor;
+
+class JniLocalObject;
+class JniObject;
+
+/**
+ * Types that hold local refs, converting to them can not happen inside
+ * a JniLocalFrame because popping it would delete the refs
+ */
+template<typename Type>
+struct JniIsLocalRef : std::integral_constant<bool, std::is_convertible<Type, jobject>::value>
+{
+};
+
+template<>
+struct JniIsLocalRef<JniLocalObject> : std::true_type
+{
+};
+
+template<typename Type>
+struct JniIsLocalRef<std::vector<Type>> : JniIsLocalRef<Type> {};
+template<typename Type>
+struct JniIsLocalRef<std::set<Type>> : JniIsLocalRef<Type> {};
+template<typename Type, size_t Size>
+struct JniIsLocalRef<std::array<Type, Size>> : JniIsLocalRef<Type> {};
+template<typename Type>
+struct JniIsLocalRef<std::list<Type>> : JniIsLocalRef<Type> {};
+template<typename Key, typename Value>
+struct JniIsLocalRef<std::map<Key, Value>> : std::integral_constant<bool,
+    JniIsLocalRef<Key>::value || JniIsLocalRef<Value>::value>
+{
+};
+
+/**
+ * The type an asynchronous call keeps of an argument or a result
+ * Java references are kept as a JniObject so they are global refs
+ * that can be used from another thread
+ */
+template<typename Type, typename Enable=void>
+struct JniAsyncType
+{
+    typedef Type type;
+};
+
+template<typename Type>
+struct JniAsyncType<Type, typename std::enable_if<std::is_convertible<Type, jobject>::value>::type>
+{
+    typedef JniObject type;
+};
+
+template<>
+struct JniAsyncType<JniLocalObject>
+{
+    typedef JniObject type;
+};
+
+/**
+ * Runs an asynchronous call and passes the result to the promise
+ */
+template<typename Return>
+struct JniAsyncTask
+{
+    static void run(std::promise<Return>& promise, const std::function<Return(JNIEnv*)>& task, JNIEnv* env)
+    {
+        promise.set_value(task(env));
+    }
+};
+
+template<>
+struct JniAsyncTask<void>
+{
+    static void run(std::promise<void>& promise, const std::function<void(JNIEnv*)>& task, JNIEnv* env)
+    {
+        task(env);
+        promise.set_value();
+    }
+};
+ 
+/**
+ * A scope for a sequence of calls on the current thread
+ * Calls made in it use the environment it holds, and the local refs they
+ * return are freed with its local frame at the end of the scope.
+ * JNI needs an ExceptionCheck before the next call, so one still runs
+ * after every operation; deferring only saves building and throwing a
+ * JniException per call. The first java exception is recorded and
+ * cleared, and the following calls return their default value without
+ * calling java. Use hasFailed() or check() to see it, an exception left
+ * at the end of the scope is logged and cleared.
+ */
+class JniSession
+{
+private:
+    JNIEnv* _env;
+    JniLocalFrame _frame;
+    bool _deferChecks;
+    jthrowable _exception;
+    JniSession* _parent;
+    static thread_local JniSession* _current;
+
+    JniSession(const JniSession& other) = delete;
+    JniSession& operator=(const JniSession& other) = delete;
+
+    /**
+     * Make the recorded exception pending again
+     */
+    void restoreException();
+public:
+    JniSession(bool deferChecks=true, jint frameChunk=JniLocalFrame::DefaultChunk);
+
+    ~JniSession();
+
+    JNIEnv* getEnvironment() const;
+
+    /**
+     * Throw a JniException if a java exception was recorded or is pending
+     */
+    void check();
+
+    /**
+     * Returns true if a session on this thread defers the checks
+     */
+    static bool isDeferringChecks();
+
+    /**
+     * Returns the environment of the session on this thread, if any
+     */
+    static JNIEnv* getCurrentEnvironment();
+
+    /**
+     * Returns true if the session on this thread recorded an exception
+     */
+    static bool hasFailed();
+
+    /**
+     * Record the first exception pending in the session on this thread
+     * and clear it so the environment stays usable
+     */
+    static void recordException(JNIEnv* env);
+};
+
+/**
+ * The reason a call returning a JniResult failed
+ */
+enum class JniError
+{
+    None,
+    NoEnvironment,
+    NoClass,
+    NoObject,
+    NoMethod,
+    NoField,
+    JavaException
+};
+
+class JniObject;
+
+/**
+ * Error state of a JniResult
+ * The message is only built when it is asked for
+ */
+class JniResultBase
+{
+private:
+    JniError _error;
+    std::shared_ptr<JniObject> _exception;
+public:
+    JniResultBase(JniError error=JniError::None);
+    JniResultBase(JniError error, const JniObject& exception);
+
+    /**
+     * Returns true if the call succeeded
+     */
+    explicit operator bool() const;
+
+    JniError getError() const;
+
+    /**
+     * The java exception thrown by the call, empty if there was none
+     */
+    JniObject getException() const;
+
+    /**
+     * Describe the error, calls java to get the exception message
+     */
+    std::string getMessage() const;
+
+    /**
+     * Throw a JniException if the call failed
+     */
+    void check() const;
+};
+
+/**
+ * The result of a call that does not throw
+ */
+template<typename Type>
+class JniResult : public JniResultBase
+{
+private:
+    Type _value;
+public:
+    JniResult(const Type& value):
+    _value(value)
+    {
+    }
+
+    JniResult(JniError error):
+    JniResultBase(error), _value()
+    {
+    }
+
+    JniResult(JniError error, const JniObject& exception):
+    JniResultBase(error, exception), _value()
+    {
+    }
+
+    const Type& getValue() const
+    {
+        return _value;
+    }
+
+    /**
+     * Returns the value or the default if the call failed
+     */
+    Type getValue(const Type& defRet) const
+    {
+        return *this ? _value : defRet;
+    }
+};
+
+template<>
+class JniResult<void> : public JniResultBase
+{
+public:
+    JniResult(JniError error=JniError::None):
+    JniResultBase(error)
+    {
+    }
+
+    JniResult(JniError error, const JniObject& exception):
+    JniResultBase(error, exception)
+    {
+    }
+};
+
+/**
+ * This class represents a jni object
+ */
+class JniObject
+{
+private:
+    template<typename Signature>
+    friend class JniMethod;
+    template<typename Signature>
+    friend class JniStaticMethod;
+    template<typename... Args>
+    friend class JniConstructor;
+    friend class JniSession;
+    friend class JniLocalFrame;
+ 
+    jclass _class;
+    jobject _instance;
+    mutable std::string _classPath;
+    mutable jclass _cacheClass = nullptr;
+
+    /**
+     * Global refs shared between copies of a shared object
+     * they are deleted when the last copy is cleared
+     */
+    struct SharedRefs
+    {
+        jclass classId;
+        jobject instance;
+        ~SharedRefs();
+    };
+    std::shared_ptr<SharedRefs> _shared;
+    bool _local;
+
+    static void checkJniException();
+    static void checkJniException(JNIEnv* env);
+
+    /**
+     * Check for a java exception after an operation
+     * while a JniSession on this thread defers the checks it is recorded
+     * instead, returns false if the session has failed
+     */
+    static bool checkCallException(JNIEnv* env);
+
+    /**
+     * Return the class of the Jni cache for the object class path
+     * it is resolved on the first call and kept on the object
+     */
+    jclass getCacheClass() const;
+
+    /**
+     * Return a method id of the object class
+     * will use the Jni method cache if the class path is known
+     */
+    jmethodID getMethodId(JNIEnv* env, const std::string& name, const std::string& signature, bool isStatic) const;
+
+    /**
+     * Return a field id of the object class
+     * will use the Jni field cache if the class path is known
+     */
+    jfieldID getFieldId(JNIEnv* env, const std::string& name, const std::string& signature, bool isStatic) const;
+ 
+    template<typename Arg, typename... Args>
+    static void buildSignature(std::ostringstream& os, const Arg& arg, const Args&... args)
+    {
+        os << getSignaturePart(arg);
+        buildSignature(os, args...);
+    }
+ 
+    static void buildSignature(std::ostringstream& os)
+    {
+    }
+ 
+    /**
+     * Return the method signature
+     * will be built at compile time if all the types are static
+     */
+    template<typename Return, typename... Args>
+    static typename std::enable_if<JniHasStaticSignatures<Return, Args...>::value, const std::string&>::type
+    createSignature(const Return& ret, const Args&... args)
+    {
+        static const std::string signature(JniSignature<Return, Args...>::type::value);
+        return signature;
+    }
+
+    template<typename Return, typename... Args>
+    static typename std::enable_if<!JniHasStaticSignatures<Return, Args...>::value, std::string>::type
+    createSignature(const Return& ret, const Args&... args)
+    {
+        std::ostringstream os;
+        os << "(";
+        buildSignature(os, args...);
+        os << ")" << getSignaturePart(ret);
+        return os.str();
+    }
+ 
+    template<typename... Args>
+    static typename std::enable_if<JniHasStaticSignatures<Args...>::value, const std::string&>::type
+    createVoidSignature(const Args&... args)
+    {
+        static const std::string signature(JniSignature<void, Args...>::type::value);
+        return signature;
+    }
+
+    template<typename... Args>
+    static typename std::enable_if<!JniHasStaticSignatures<Args...>::value, std::string>::type
+    createVoidSignature(const Args&... args)
+    {
+        std::ostringstream os;
+        os << "(";
+        buildSignature(os, args...);
+        os << ")" << getSignaturePart();
+        return os.str();
+    }
+
+    /**
+     * Return the signature of a field type
+     */
+    template<typename Type>
+    static typename std::enable_if<JniHasStaticSignature<Type>::value, const std::string&>::type
+    createFieldSignature(const Type& val)
+    {
+        static const std::string signature(JniSignatureType<Type>::type::value);
+        return signature;
+    }
+
+    template<typename Type>
+    static typename std::enable_if<!JniHasStaticSignature<Type>::value, std::string>::type
+    createFieldSignature(const Type& val)
+    {
+        return getSignaturePart(val);
+    }
+ 
+    template<typename... Args>
+    static std::array<jvalue, sizeof...(Args)> createArguments(const Args&... args)
+    {
+        std::array<jvalue, sizeof...(Args)> jargs;
+        buildArguments(jargs.data(), 0, args...);
+        return jargs;
+    }
+ 
+    template<typename Arg, typename... Args>
+    static void buildArguments(jvalue* jargs, unsigned pos, const Arg& arg, const Args&... args)
+    {
+        jargs[pos] = convertToJavaValue(arg);
+        buildArguments(jargs, pos+1, args...);
+        
+    }
+ 
+    static void buildArguments(jvalue* jargs, unsigned pos)
+    {
+    }
+
+    template<typename Arg, typename... Args>
+    static void deleteObjectArguments(JNIEnv* env, jvalue* jargs, unsigned pos, const Arg& arg, const Args&... args)
+    {
+        if(JniIsObjectArgument<Arg>::value)
+        {
+            env->DeleteLocalRef(jargs[pos].l);
+        }
+        deleteObjectArguments(env, jargs, pos+1, args...);
+    }
+
+    static void deleteObjectArguments(JNIEnv* env, jvalue* jargs, unsigned pos)
+    {
+    }
+    
+    /**
+     * Return the signature for the given type
+     */
+    template<typename Type>
+    static std::string getSignaturePart(const Type& type);
+ 
+    /**
+    * Return the signature for the given container element
+    */
+    template<typename Type>
+    static std::string getContainerElementSignaturePart(const Type& container)
+    {
+        if(container.empty())
+        {
+            return getSignaturePart(typename Type::value_type());
+        }
+        else
+        {
+            return getSignaturePart(*container.begin());
+        }
+    }
+ 
+    // template specialization for pointers
+    // java references are objects, other pointers are passed as longs
+    template<typename Type>
+    static typename std::enable_if<!std::is_convertible<Type*, jobject>::value, std::string>::type
+    getSignaturePart(Type* val)
+    {
+        return getSignaturePart((jlong)val);
+    }
+
+    template<typename Type>
+    static typename std::enable_if<std::is_convertible<Type*, jobject>::value, std::string>::type
+    getSignaturePart(Type* val)
+    {
+        return getSignaturePart<jobject>(val);
+    }
+ 
+    // template specialization for containers
+    template<typename Type>
+    static std::string getSignaturePart(const std::vector<Type>& val)
+    {
+        return std::string("[")+getContainerElementSignaturePart(val);
+    }
+    template<typename Type>
+    static std::string getSignaturePart(const std::set<Type>& val)
+    {
+        return std::string("[")+getContainerElementSignaturePart(val);
+    }
+    template<typename Type, size_t Size>
+    static std::string getSignaturePart(const std::array<Type, Size>& val)
+    {
+        return std::string("[")+getContainerElementSignaturePart(val);
+    }
+    template<typename Type>
+    static std::string getSignaturePart(const std::list<Type>& val)
+    {
+        return std::string("[")+getContainerElementSignaturePart(val);
+    }
+    template<typename Key, typename Value>
+    static std::string getSignaturePart(const std::map<Key, Value>& val)
+    {
+        return "Ljava/util/Map;";
+    }
+ 
+    /**
+     * Return the signature for the void type
+     */
+    static std::string getSignaturePart();
+ 
+    template<typename Return>
+    static Return callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args);
+ 
+    static void callJavaVoidMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args);
+
+    template<typename Return>
+    static Return callCheckedJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args)
+    {
+        Return result = Return();
+        if(JniSession::hasFailed())
+        {
+            return result;
+        }
+        callJavaMethod(env, objId, methodId, args, result);
+        checkCallException(env);
+        return result;
+    }
+
+    template<typename Return>
+    static Return callCheckedStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args)
+    {
+        if(JniSession::hasFailed())
+        {
+            return Return();
+        }
+        Return result = callStaticJavaMethod<Return>(env, classId, methodId, args);
+        checkCallException(env);
+        return result;
+    }
+
+    /**
+     * Resolve a class and a method for the prepared method handles
+     * will throw a JniException if they are not found
+     */
+    static jclass resolveClass(const std::string& classPath);
+
+    /**
+     * The calls run by the asynchronous api on the copied object and arguments
+     * The signature is created from the original arguments by the caller
+     */
+    template<typename Return, typename... Args>
+    static Return callCopy(JNIEnv* env, JniObject obj, const std::string& name, const std::string& signature, const Return& defRet, const Args&... args)
+    {
+        return obj.callSigned(env, name, signature, defRet, args...);
+    }
+
+    template<typename... Args>
+    static void callVoidCopy(JNIEnv* env, JniObject obj, const std::string& name, const std::string& signature, const Args&... args)
+    {
+        obj.callSignedVoid(env, name, signature, args...);
+    }
+
+    template<typename Return, typename... Args>
+    static Return staticCallCopy(JNIEnv* env, JniObject obj, const std::string& name, const std::string& signature, const Return& defRet, const Args&... args)
+    {
+        return obj.staticCallSigned(env, name, signature, defRet, args...);
+    }
+
+    template<typename... Args>
+    static void staticCallVoidCopy(JNIEnv* env, JniObject obj, const std::string& name, const std::string& signature, const Args&... args)
+    {
+        obj.staticCallSignedVoid(env, name, signature, args...);
+    }
+
+    /**
+     * Run a task on the worker pool, its result or exception is set on the future
+     */
+    template<typename Return>
+    static std::future<Return> postAsync(const std::function<Return(JNIEnv*)>& task)
+    {
+        std::shared_ptr<std::promise<Return>> promise = std::make_shared<std::promise<Return>>();
+        std::future<Return> future = promise->get_future();
+        Jni::get().getWorkers().post([promise, task](JNIEnv* env){
+            try
+            {
+                JniAsyncTask<Return>::run(*promise, task, env);
+            }
+            catch(...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+    /**
+     * Check that there is an environment, a class and an instance for a call
+     */
+    JniError checkCall(JNIEnv* env, bool isStatic) const;
+
+    /**
+     * Call without checking for exceptions, returns false if one is pending
+     * Object results are only converted once the call did not throw
+     */
+    template<typename Return>
+    static typename std::enable_if<JniIsDirectResult<Return>::value, bool>::type
+    callUncheckedJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, Return& out)
+    {
+        callJavaMethod(env, objId, methodId, args, out);
+        return !env->ExceptionCheck();
+    }
+
+    template<typename Return>
+    static typename std::enable_if<!JniIsDirectResult<Return>::value, bool>::type
+    callUncheckedJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, Return& out)
+    {
+        jobject jout = nullptr;
+        callJavaMethod(env, objId, methodId, args, jout);
+        return convertUncheckedResult(env, jout, out);
+    }
+
+    template<typename Return>
+    static typename std::enable_if<JniIsDirectResult<Return>::value, bool>::type
+    callUncheckedStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args, Return& out)
+    {
+        out = callStaticJavaMethod<Return>(env, classId, methodId, args);
+        return !env->ExceptionCheck();
+    }
+
+    template<typename Return>
+    static typename std::enable_if<!JniIsDirectResult<Return>::value, bool>::type
+    callUncheckedStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args, Return& out)
+    {
+        jobject jout = callStaticJavaMethod<jobject>(env, classId, methodId, args);
+        return convertUncheckedResult(env, jout, out);
+    }
+
+    template<typename Return>
+    typename std::enable_if<JniIsDirectResult<Return>::value, bool>::type
+    getUncheckedJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, Return& out)
+    {
+        out = getJavaField<Return>(env, objId, fieldId);
+        return !env->ExceptionCheck();
+    }
+
+    template<typename Return>
+    typename std::enable_if<!JniIsDirectResult<Return>::value, bool>::type
+    getUncheckedJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, Return& out)
+    {
+        jobject jout = getJavaField<jobject>(env, objId, fieldId);
+        return convertUncheckedResult(env, jout, out);
+    }
+
+    template<typename Return>
+    static bool convertUncheckedResult(JNIEnv* env, jobject jout, Return& out)
+    {
+        if(env->ExceptionCheck())
+        {
+            return false;
+        }
+        convertFromJavaObject(env, jout, out);
+        return !env->ExceptionCheck();
+    }
+    static jmethodID resolveMethod(jclass classId, const std::string& name, const std::string& signature, bool isStatic);
+
+    /**
+     * The class and methods of a boxed primitive wrapper
+     */
+    struct BoxedMethods
+    {
+        jclass classId;
+        jmethodID valueOf;
+        jmethodID value;
+    };
+
+    /**
+     * The methods used by the direct buffers and the native byte order
+     * The order is kept as a global ref
+     */
+    struct BufferMethods
+    {
+        jobject nativeOrder;
+        jmethodID order;
+        jmethodID position;
+        jmethodID limit;
+    };
+
+    static BufferMethods resolveBufferMethods();
+    static const BufferMethods& getBufferMethods();
+
+    /**
+     * Well known classes used to dispatch container conversions
+     * They are resolved once through the class cache
+     */
+    static jclass getCollectionClass();
+    static jclass getMapClass();
+    static jclass getByteBufferClass();
+
+    static BoxedMethods resolveBoxedMethods(const char* classPath, const char* valueOfSignature, const char* valueName, const char* valueSignature);
+
+    template<typename Type>
+    static const BoxedMethods& getBoxedMethods()
+    {
+        static const BoxedMethods methods = resolveBoxedMethods(JniBoxed<Type>::classPath(),
+            JniBoxed<Type>::valueOfSignature(), JniBoxed<Type>::valueName(), JniBoxed<Type>::valueSignature());
+        return methods;
+    }
+
+    template<typename Return>
+    static void callJavaObjectMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, Return& out)
+    {
+        jobject jout = nullptr;
+        callJavaMethod(env, objId, methodId, args, jout);
+        if(!checkCallException(env))
+        {
+            return;
+        }
+        out = convertFromJavaObject<Return>(jout);
+    }
+
+    template<typename Return>
+    static void callJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, Return& out)
+    {
+        callJavaObjectMethod(env, objId, methodId, args, out);
+    }
+
+    template<typename Type>
+    static void callJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, std::vector<Type>& out)
+    {
+        callJavaObjectMethod(env, objId, methodId, args, out);
+    }
+ 
+    template<typename Return>
+    Return getJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId);
+ 
+    template<typename Return>
+    Return getJavaField(JNIEnv* env, jobject objId, jfieldID fieldId);
+
+    template<typename Type>
+    void setJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId, const Type& value);
+
+    template<typename Type>
+    void setJavaField(JNIEnv* env, jobject objId, jfieldID fieldId, const Type& value);
+ 
+protected:
+    JniObject(bool local, jobject javaObj, jclass classId, const std::string& classPath);
+
+    void copy(const JniObject& other);
+    void move(JniObject& other);
+
+public:
+    JniObject(const std::string& classPath, jobject javaObj=nullptr, jclass classId=nullptr);
+    JniObject(jclass classId, jobject javaObj);
+    JniObject(jobject javaObj=nullptr);
+    JniObject(const JniObject& other);
+    JniObject(JniObject&& other);
+    void init(jobject javaObj=nullptr, jclass classId=nullptr, const std::string& classPath="");
+    ~JniObject();
+ 
+    /**
+     * Clear the retained global references
+     */
+    void clear();
+
+    /**
+     * Share the global references of this object
+     * Copies of a shared object reuse them instead of creating new ones
+     */
+    void makeShared();
+
+    /**
+     * Returns true if the global references are shared between copies
+     */
+    bool isShared() const;
+ 
+    /**
+     * Find a singleton instance
+     * will try the `instance` static field and a `getInstance` static method
+     * the instance is cached, see Jni::invalidateSingleton
+     */
+    static JniObject findSingleton(const std::string& classPath);
+
+    /**
+     * Create a direct java.nio.ByteBuffer over native memory
+     * The memory is not copied or owned by java, it has to stay valid
+     * until the java side stops using the buffer. The buffer uses the
+     * native byte order
+     */
+    static JniObject createDirectBuffer(void* data, size_t size);
+
+    template<typename Type>
+    static JniObject createDirectBuffer(Type* data, size_t count)
+    {
+        return createDirectBuffer(static_cast<void*>(data), count*sizeof(Type));
+    }
+
+    template<typename Type>
+    static JniObject createDirectBuffer(std::vector<Type>& data)
+    {
+        return createDirectBuffer(data.data(), data.size());
+    }
+ 
+    /**
+     * Create a new JniObject
+     */
+    template<typename... Args>
+    static JniObject createNew(const std::string& classPath, Args&&... args)
+    {
+        JniObject defRet(classPath);
+        JNIEnv* env = getEnvironment();
+        if(!env)
+        {
+            return defRet;
+        }
+        jclass classId = Jni::get().getClass(classPath);
+        if(!classId)
+        {
+            return defRet;
+        }
+        const std::string& signature = createVoidSignature(args...);
+        jmethodID methodId = Jni::get().getMethodId(classId, "<init>", signature);
+        checkJniException();
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        jobject obj = env->NewObjectA(classId, methodId, jargs.data());
+        cleanupArguments(env, jargs.data(), args...);
+        checkJniException();
+        defRet = JniObject(classPath, obj, classId);
+        return defRet;
+    }
+
+    /**
+     * Create a new collection with an initial capacity
+     * Uses the default constructor if the class has no (int) one
+     */
+    static JniObject createNewWithCapacity(const std::string& classPath, jint capacity);
+
+    template<typename... Args>
+    static void cleanupArguments(JNIEnv* env, jvalue* jargs, Args&&... args)
+    {
+        deleteObjectArguments(env, jargs, 0, args...);
+    }
+ 
+    /**
+     * Calls an object method
+     */
+    template<typename Return, typename... Args>
+    Return call(const std::string& name, const Return& defRet, Args&&... args)
+    {
+        const std::string& signature = createSignature(defRet, args...);
+        return callSigned(name, signature, defRet, args...);
+    }
+
+    template<typename Return, typename... Args>
+    Return call(JNIEnv* env, const std::string& name, const Return& defRet, Args&&... args)
+    {
+        const std::string& signature = createSignature(defRet, args...);
+        return callSigned(env, name, signature, defRet, args...);
+    }
+ 
+    template<typename Return, typename... Args>
+    Return callSigned(const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
+    {
+        return callSigned(getEnvironment(), name, signature, defRet, args...);
+    }
+
+    template<typename Return, typename... Args>
+    Return callSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
+    {
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        if(JniSession::hasFailed())
+        {
+            return defRet;
+        }
+        jclass classId = getClass();
+        if(!classId)
+        {
+            throw JniException("no class found");
+        }
+        jobject objId = getInstance();
+        if(!objId)
+        {
+            throw JniException("no object found");
+        }
+        jmethodID methodId = getMethodId(env, name, signature, false);
+        if(!methodId)
+        {
+            checkJniException(env);
+        }
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        Return result;
+        callJavaMethod(env, objId, methodId, jargs.data(), result);
+        cleanupArguments(env, jargs.data(), args...);
+        if(!checkCallException(env))
+        {
+            return defRet;
+        }
+        return result;
+    }
+ 
+    /**
+     * Calls an object void method
+     */
+    template<typename... Args>
+    void callVoid(const std::string& name, Args&&... args)
+    {
+        const std::string& signature = createVoidSignature(args...);
+        return callSignedVoid(name, signature, args...);
+    }
+
+    template<typename... Args>
+    void callVoid(JNIEnv* env, const std::string& name, Args&&... args)
+    {
+        const std::string& signature = createVoidSignature(args...);
+        return callSignedVoid(env, name, signature, args...);
+    }
+ 
+    template<typename... Args>
+    void callSignedVoid(const std::string& name, const std::string& signature, Args&&... args)
+    {
+        return callSignedVoid(getEnvironment(), name, signature, args...);
+    }
+
+    template<typename... Args>
+    void callSignedVoid(JNIEnv* env, const std::string& name, const std::string& signature, Args&&... args)
+    {
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        if(JniSession::hasFailed())
+        {
+            return;
+        }
+        jclass classId = getClass();
+        if(!classId)
+        {
+            throw JniException("no class found");
+        }
+        jobject objId = getInstance();
+        if(!objId)
+        {
+            throw JniException("no object found");
+        }
+        jmethodID methodId = getMethodId(env, name, signature, false);
+        if(!methodId)
+        {
+            checkJniException(env);
+        }
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        callJavaVoidMethod(env, objId, methodId, jargs.data());
+        cleanupArguments(env, jargs.data(), args...);
+        checkCallException(env);
+    }
+ 
+    /**
+     * Calls a class method
+     */
+    template<typename Return, typename... Args>
+    Return staticCall(const std::string& name, const Return& defRet, Args&&... args)
+    {
+        const std::string& signature = createSignature(defRet, args...);
+        return staticCallSigned(name, signature, defRet, args...);
+    }
+
+    template<typename Return, typename... Args>
+    Return staticCall(JNIEnv* env, const std::string& name, const Return& defRet, Args&&... args)
+    {
+        const std::string& signature = createSignature(defRet, args...);
+        return staticCallSigned(env, name, signature, defRet, args...);
+    }
+ 
+    template<typename Return, typename... Args>
+    Return staticCallSigned(const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
+    {
+        return staticCallSigned(getEnvironment(), name, signature, defRet, args...);
+    }
+
+    template<typename Return, typename... Args>
+    Return staticCallSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
+    {
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        if(JniSession::hasFailed())
+        {
+            return defRet;
+        }
+        jclass classId = getClass();
+        if(!classId)
+        {
+            throw JniException("no class found");
+        }
+        jmethodID methodId = getMethodId(env, name, signature, true);
+        if(!methodId)
+        {
+            checkJniException(env);
+        }
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        Return result = callStaticJavaMethod<Return>(env, classId, methodId, jargs.data());
+        cleanupArguments(env, jargs.data(), args...);
+        if(!checkCallException(env))
+        {
+            return defRet;
+        }
+        return result;
+    }
+ 
+    /**
+     * Calls a class void method
+     */
+    template<typename... Args>
+    void staticCallVoid(const std::string& name, Args&&... args)
+    {
+        const std::string& signature = createVoidSignature(args...);
+        return staticCallSignedVoid(name, signature, args...);
+    }
+
+    template<typename... Args>
+    void staticCallVoid(JNIEnv* env, const std::string& name, Args&&... args)
+    {
+        const std::string& signature = createVoidSignature(args...);
+        return staticCallSignedVoid(env, name, signature, args...);
+    }
+ 
+    template<typename... Args>
+    void staticCallSignedVoid(const std::string& name, const std::string& signature, Args&&... args)
     {
-        return std::string("[")+getContainerElementSignaturePart(val);
+        return staticCallSignedVoid(getEnvironment(), name, signature, args...);
     }
-    template<typename Key, typename Value>
-    static std::string getSignaturePart(const std::map<Key, Value>& val)
+
+    template<typename... Args>
+    void staticCallSignedVoid(JNIEnv* env, const std::string& name, const std::string& signature, Args&&... args)
     {
-        return "Ljava/util/Map;";
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        if(JniSession::hasFailed())
+        {
+            return;
+        }
+        jclass classId = getClass();
+        if(!classId)
+        {
+            throw JniException("no class found");
+        }
+        jmethodID methodId = getMethodId(env, name, signature, true);
+        if(!methodId)
+        {
+            checkJniException(env);
+        }
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        callStaticJavaMethod<void>(env, classId, methodId, jargs.data());
+        cleanupArguments(env, jargs.data(), args...);
+        checkCallException(env);
     }
  
     /**
-     * Return the signature for the void type
+     * Get a static class field
+     * @param name the field name
      */
-    static std::string getSignaturePart();
- 
     template<typename Return>
-    Return callStaticJavaMethod(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args);
- 
-    void callJavaVoidMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args);
-
-    template<typename Return>
-    void callJavaObjectMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, Return& out)
+    Return staticField(const std::string& name, const Return& defRet)
     {
-        jobject jout = nullptr;
-        callJavaMethod(env, objId, methodId, args, jout);
-        checkJniException();
-        out = convertFromJavaObject<Return>(jout);
+        const std::string& signature = createFieldSignature(defRet);
+        return staticFieldSigned(name, signature, defRet);
     }
 
     template<typename Return>
-    void callJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, Return& out)
-    {
-        callJavaObjectMethod(env, objId, methodId, args, out);
-    }
-
-    template<typename Type>
-    void callJavaMethod(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args, std::vector<Type>& out)
+    Return staticField(JNIEnv* env, const std::string& name, const Return& defRet)
     {
-        callJavaObjectMethod(env, objId, methodId, args, out);
+        const std::string& signature = createFieldSignature(defRet);
+        return staticFieldSigned(env, name, signature, defRet);
     }
  
     template<typename Return>
-    Return getJavaStaticField(JNIEnv* env, jclass classId, jfieldID fieldId);
- 
+    Return staticFieldSigned(const std::string& name, const std::string& signature, const Return& defRet)
+    {
+        return staticFieldSigned(getEnvironment(), name, signature, defRet);
+    }
+
     template<typename Return>
-    Return getJavaField(JNIEnv* env, jobject objId, jfieldID fieldId);
- 
-public:
-    JniObject(const std::string& classPath, jobject javaObj=nullptr, jclass classId=nullptr);
-    JniObject(jclass classId, jobject javaObj);
-    JniObject(jobject javaObj=nullptr);
-    JniObject(const JniObject& other);
-    void init(jobject javaObj=nullptr, jclass classId=nullptr, const std::string& classPath="");
-    ~JniObject();
- 
-    /**
-     * Clear the retained global references
-     */
-    void clear();
- 
-    /**
-     * Find a singleton instance
-     * will try the `instance` static field and a `getInstance` static method
-     */
-    static JniObject findSingleton(const std::string& classPath);
- 
-    /**
-     * Create a new JniObject
-     */
-    template<typename... Args>
-    static JniObject createNew(const std::string& classPath, Args&&... args)
+    Return staticFieldSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Return& defRet)
     {
-        JniObject defRet(classPath);
-        JNIEnv* env = getEnvironment();
         if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        if(JniSession::hasFailed())
         {
             return defRet;
         }
-        jclass classId = Jni::get().getClass(classPath);
+ 
+        jclass classId = getClass();
         if(!classId)
+        {
+            throw JniException("no class found");
+        }
+ 
+        jfieldID fieldId = getFieldId(env, name, signature, true);
+        if(!fieldId)
+        {
+            checkJniException(env);
+        }
+        Return result = getJavaStaticField<Return>(env, classId, fieldId);
+        if(!checkCallException(env))
         {
             return defRet;
         }
-        std::string signature(createVoidSignature<Args...>(args...));
-        jmethodID methodId = env->GetMethodID(classId, "<init>", signature.c_str());
-        checkJniException();
-        jvalue* jargs = createArguments(args...);
-        jobject obj = env->NewObjectA(classId, methodId, jargs);
-        checkJniException();
-        defRet = JniObject(classPath, obj, classId);
-        return defRet;
+        return result;
     }
 
-    template<typename... Args>
-    void cleanupArguments(JNIEnv* env, jvalue* jargs, Args&&... args)
+    /**
+     * Set a static class field
+     * @param name the field name
+     */
+    template<typename Type>
+    void setStaticField(const std::string& name, const Type& value)
     {
-        std::vector<jobject*> jobjs;
-        findObjectArguments(jobjs, jargs, args...);
-        for(jobject* jobj : jobjs)
+        const std::string& signature = createFieldSignature(value);
+        setStaticFieldSigned(name, signature, value);
+    }
+
+    template<typename Type>
+    void setStaticField(JNIEnv* env, const std::string& name, const Type& value)
+    {
+        const std::string& signature = createFieldSignature(value);
+        setStaticFieldSigned(env, name, signature, value);
+    }
+
+    template<typename Type>
+    void setStaticFieldSigned(const std::string& name, const std::string& signature, const Type& value)
+    {
+        return setStaticFieldSigned(getEnvironment(), name, signature, value);
+    }
+
+    template<typename Type>
+    void setStaticFieldSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Type& value)
+    {
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        if(JniSession::hasFailed())
         {
-            env->DeleteLocalRef(*jobj);
+            return;
         }
+
+        jclass classId = getClass();
+        if(!classId)
+        {
+            throw JniException("no class found");
+        }
+
+        jfieldID fieldId = getFieldId(env, name, signature, true);
+        if(!fieldId)
+        {
+            checkJniException(env);
+        }
+        setJavaStaticField(env, classId, fieldId, value);
+        checkCallException(env);
     }
  
     /**
-     * Calls an object method
+     * Get a object field
+     * @param name the field name
      */
-    template<typename Return, typename... Args>
-    Return call(const std::string& name, const Return& defRet, Args&&... args)
+    template<typename Return>
+    Return field(const std::string& name, const Return& defRet)
     {
-        std::string signature(createSignature(defRet, args...));
-        return callSigned(name, signature, defRet, args...);
+        const std::string& signature = createFieldSignature(defRet);
+        return fieldSigned(name, signature, defRet);
+    }
+
+    template<typename Return>
+    Return field(JNIEnv* env, const std::string& name, const Return& defRet)
+    {
+        const std::string& signature = createFieldSignature(defRet);
+        return fieldSigned(env, name, signature, defRet);
     }
  
-    template<typename Return, typename... Args>
-    Return callSigned(const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
+    template<typename Return>
+    Return fieldSigned(const std::string& name, const std::string& signature, const Return& defRet)
+    {
+        return fieldSigned(getEnvironment(), name, signature, defRet);
+    }
+
+    template<typename Return>
+    Return fieldSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Return& defRet)
     {
-        JNIEnv* env = getEnvironment();
         if(!env)
         {
             throw JniException("no environment found");
         }
+        if(JniSession::hasFailed())
+        {
+            return defRet;
+        }
+ 
         jclass classId = getClass();
         if(!classId)
         {
             throw JniException("no class found");
         }
+ 
         jobject objId = getInstance();
         if(!objId)
         {
             throw JniException("no object found");
         }
-        jmethodID methodId = env->GetMethodID(classId, name.c_str(), signature.c_str());
-        checkJniException();
-        jvalue* jargs = createArguments(args...);
-        Return result;
-        callJavaMethod(env, objId, methodId, jargs, result);
-        cleanupArguments(env, jargs, args...);
-        checkJniException();
+ 
+        jfieldID fieldId = getFieldId(env, name, signature, false);
+        if(!fieldId)
+        {
+            checkJniException(env);
+        }
+        Return result = getJavaField<Return>(env, objId, fieldId);
+        if(!checkCallException(env))
+        {
+            return defRet;
+        }
         return result;
     }
- 
+
     /**
-     * Calls an object void method
+     * Set an object field
+     * @param name the field name
      */
-    template<typename... Args>
-    void callVoid(const std::string& name, Args&&... args)
+    template<typename Type>
+    void setField(const std::string& name, const Type& value)
     {
-        std::string signature(createVoidSignature(args...));
-        return callSignedVoid(name, signature, args...);
+        const std::string& signature = createFieldSignature(value);
+        setFieldSigned(name, signature, value);
     }
- 
-    template<typename... Args>
-    void callSignedVoid(const std::string& name, const std::string& signature, Args&&... args)
+
+    template<typename Type>
+    void setField(JNIEnv* env, const std::string& name, const Type& value)
+    {
+        const std::string& signature = createFieldSignature(value);
+        setFieldSigned(env, name, signature, value);
+    }
+
+    template<typename Type>
+    void setFieldSigned(const std::string& name, const std::string& signature, const Type& value)
+    {
+        return setFieldSigned(getEnvironment(), name, signature, value);
+    }
+
+    template<typename Type>
+    void setFieldSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Type& value)
     {
-        JNIEnv* env = getEnvironment();
         if(!env)
         {
             throw JniException("no environment found");
         }
+        if(JniSession::hasFailed())
+        {
+            return;
+        }
+
         jclass classId = getClass();
         if(!classId)
         {
             throw JniException("no class found");
         }
+
         jobject objId = getInstance();
         if(!objId)
         {
             throw JniException("no object found");
         }
-        jmethodID methodId = env->GetMethodID(classId, name.c_str(), signature.c_str());
-        checkJniException();
-        jvalue* jargs = createArguments(args...);
-        callJavaVoidMethod(env, objId, methodId, jargs);
-        cleanupArguments(env, jargs, args...);
-        checkJniException();
+
+        jfieldID fieldId = getFieldId(env, name, signature, false);
+        if(!fieldId)
+        {
+            checkJniException(env);
+        }
+        setJavaField(env, objId, fieldId, value);
+        checkCallException(env);
     }
  
     /**
-     * Calls a class method
+     * Calls an object method on a thread of Jni::getWorkers
+     * The signature is created here from the original arguments, they are
+     * copied and java references are kept as global refs.
+     * Object results are returned as a JniObject
      */
     template<typename Return, typename... Args>
-    Return staticCall(const std::string& name, const Return& defRet, Args&&... args)
+    std::future<typename JniAsyncType<Return>::type> callAsync(const std::string& name, const Return& defRet, Args&&... args) const
     {
-        std::string signature(createSignature(defRet, args...));
-        return staticCallSigned(name, signature, defRet, args...);
+        typedef typename JniAsyncType<Return>::type AsyncReturn;
+        const std::string& signature = createSignature(defRet, args...);
+        std::function<AsyncReturn(JNIEnv*)> task = std::bind(
+            &JniObject::callCopy<AsyncReturn, typename JniAsyncType<typename std::decay<Args>::type>::type...>,
+            std::placeholders::_1, JniObject(*this), name, signature, AsyncReturn(defRet),
+            typename JniAsyncType<typename std::decay<Args>::type>::type(std::forward<Args>(args))...);
+        return postAsync(task);
     }
- 
+
+    template<typename... Args>
+    std::future<void> callVoidAsync(const std::string& name, Args&&... args) const
+    {
+        const std::string& signature = createVoidSignature(args...);
+        std::function<void(JNIEnv*)> task = std::bind(
+            &JniObject::callVoidCopy<typename JniAsyncType<typename std::decay<Args>::type>::type...>,
+            std::placeholders::_1, JniObject(*this), name, signature,
+            typename JniAsyncType<typename std::decay<Args>::type>::type(std::forward<Args>(args))...);
+        return postAsync(task);
+    }
+
+    /**
+     * Calls a class method on a thread of Jni::getWorkers
+     */
     template<typename Return, typename... Args>
-    Return staticCallSigned(const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
+    std::future<typename JniAsyncType<Return>::type> staticCallAsync(const std::string& name, const Return& defRet, Args&&... args) const
     {
-        JNIEnv* env = getEnvironment();
-        if(!env)
+        typedef typename JniAsyncType<Return>::type AsyncReturn;
+        const std::string& signature = createSignature(defRet, args...);
+        std::function<AsyncReturn(JNIEnv*)> task = std::bind(
+            &JniObject::staticCallCopy<AsyncReturn, typename JniAsyncType<typename std::decay<Args>::type>::type...>,
+            std::placeholders::_1, JniObject(*this), name, signature, AsyncReturn(defRet),
+            typename JniAsyncType<typename std::decay<Args>::type>::type(std::forward<Args>(args))...);
+        return postAsync(task);
+    }
+
+    template<typename... Args>
+    std::future<void> staticCallVoidAsync(const std::string& name, Args&&... args) const
+    {
+        const std::string& signature = createVoidSignature(args...);
+        std::function<void(JNIEnv*)> task = std::bind(
+            &JniObject::staticCallVoidCopy<typename JniAsyncType<typename std::decay<Args>::type>::type...>,
+            std::placeholders::_1, JniObject(*this), name, signature,
+            typename JniAsyncType<typename std::decay<Args>::type>::type(std::forward<Args>(args))...);
+        return postAsync(task);
+    }
+
+    /**
+     * Calls an object method without throwing
+     * Failures are returned in the result together with the java exception
+     */
+    template<typename Return, typename... Args>
+    JniResult<Return> tryCall(const std::string& name, const Return& defRet, Args&&... args)
+    {
+        const std::string& signature = createSignature(defRet, args...);
+        return tryCallSigned(getEnvironment(), name, signature, defRet, args...);
+    }
+
+    template<typename Return, typename... Args>
+    JniResult<Return> tryCallSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
+    {
+        JniError error = checkCall(env, false);
+        if(error != JniError::None)
         {
-            throw JniException("no environment found");
+            return JniResult<Return>(error);
         }
-        jclass classId = getClass();
-        if(!classId)
+        jmethodID methodId = getMethodId(env, name, signature, false);
+        if(!methodId)
         {
-            throw JniException("no class found");
+            env->ExceptionClear();
+            return JniResult<Return>(JniError::NoMethod);
         }
-        jmethodID methodId = env->GetStaticMethodID(classId, name.c_str(), signature.c_str());
-        checkJniException();
-        jvalue* jargs = createArguments(args...);
-        Return result = callStaticJavaMethod<Return>(env, classId, methodId, jargs);
-        cleanupArguments(env, jargs, args...);
-        checkJniException();
-        return result;
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        Return result;
+        bool called = callUncheckedJavaMethod(env, getInstance(), methodId, jargs.data(), result);
+        cleanupArguments(env, jargs.data(), args...);
+        if(!called)
+        {
+            return JniResult<Return>(JniError::JavaException, takeJniException(env));
+        }
+        return JniResult<Return>(result);
     }
- 
+
     /**
-     * Calls a class void method
+     * Calls an object void method without throwing
      */
     template<typename... Args>
-    void staticCallVoid(const std::string& name, Args&&... args)
+    JniResult<void> tryCallVoid(const std::string& name, Args&&... args)
     {
-        std::string signature(createVoidSignature(args...));
-        return staticCallSignedVoid(name, signature, args...);
+        const std::string& signature = createVoidSignature(args...);
+        return tryCallSignedVoid(getEnvironment(), name, signature, args...);
     }
- 
+
     template<typename... Args>
-    void staticCallSignedVoid(const std::string& name, const std::string& signature, Args&&... args)
+    JniResult<void> tryCallSignedVoid(JNIEnv* env, const std::string& name, const std::string& signature, Args&&... args)
     {
-        JNIEnv* env = getEnvironment();
-        if(!env)
+        JniError error = checkCall(env, false);
+        if(error != JniError::None)
         {
-            throw JniException("no environment found");
+            return JniResult<void>(error);
         }
-        jclass classId = getClass();
-        if(!classId)
+        jmethodID methodId = getMethodId(env, name, signature, false);
+        if(!methodId)
         {
-            throw JniException("no class found");
+            env->ExceptionClear();
+            return JniResult<void>(JniError::NoMethod);
         }
-        jmethodID methodId = env->GetStaticMethodID(classId, name.c_str(), signature.c_str());
-        checkJniException();
-        jvalue* jargs = createArguments(args...);
-        callStaticJavaMethod<void>(env, classId, methodId, jargs);
-        cleanupArguments(env, jargs, args...);
-        checkJniException();
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        callJavaVoidMethod(env, getInstance(), methodId, jargs.data());
+        cleanupArguments(env, jargs.data(), args...);
+        if(env->ExceptionCheck())
+        {
+            return JniResult<void>(JniError::JavaException, takeJniException(env));
+        }
+        return JniResult<void>();
     }
- 
+
     /**
-     * Get a static class field
-     * @param name the field name
+     * Calls a class method without throwing
      */
-    template<typename Return>
-    Return staticField(const std::string& name, const Return& defRet)
+    template<typename Return, typename... Args>
+    JniResult<Return> tryStaticCall(const std::string& name, const Return& defRet, Args&&... args)
     {
-        std::string signature(getSignaturePart<Return>(defRet));
-        return staticFieldSigned(name, signature, defRet);
-    }
- 
-    template<typename Return>
-    Return staticFieldSigned(const std::string& name, const std::string& signature, const Return& defRet)
+        const std::string& signature = createSignature(defRet, args...);
+        return tryStaticCallSigned(getEnvironment(), name, signature, defRet, args...);
+    }
+
+    template<typename Return, typename... Args>
+    JniResult<Return> tryStaticCallSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Return& defRet, Args&&... args)
     {
-        JNIEnv* env = getEnvironment();
-        if(!env)
+        JniError error = checkCall(env, true);
+        if(error != JniError::None)
         {
-            throw JniException("no environment found");
+            return JniResult<Return>(error);
         }
- 
-        jclass classId = getClass();
-        if(!classId)
+        jmethodID methodId = getMethodId(env, name, signature, true);
+        if(!methodId)
         {
-            throw JniException("no class found");
+            env->ExceptionClear();
+            return JniResult<Return>(JniError::NoMethod);
         }
- 
-        jfieldID fieldId = env->GetStaticFieldID(classId, name.c_str(), signature.c_str());
-        checkJniException();
-        Return result = getJavaStaticField<Return>(env, classId, fieldId);
-        checkJniException();
-        return result;
+        std::array<jvalue, sizeof...(Args)> jargs(createArguments(args...));
+        Return result;
+        bool called = callUncheckedStaticJavaMethod(env, getClass(), methodId, jargs.data(), result);
+        cleanupArguments(env, jargs.data(), args...);
+        if(!called)
+        {
+            return JniResult<Return>(JniError::JavaException, takeJniException(env));
+        }
+        return JniResult<Return>(result);
     }
- 
+
     /**
-     * Get a object field
-     * @param name the field name
+     * Get an object field without throwing
      */
     template<typename Return>
-    Return field(const std::string& name, const Return& defRet)
+    JniResult<Return> tryField(const std::string& name, const Return& defRet)
     {
-        std::string signature(getSignaturePart<Return>(defRet));
-        return fieldSigned(name, signature, defRet);
+        const std::string& signature = createFieldSignature(defRet);
+        return tryFieldSigned(getEnvironment(), name, signature, defRet);
     }
- 
+
     template<typename Return>
-    Return fieldSigned(const std::string& name, const std::string& signature, const Return& defRet)
+    JniResult<Return> tryFieldSigned(JNIEnv* env, const std::string& name, const std::string& signature, const Return& defRet)
     {
-        JNIEnv* env = getEnvironment();
-        if(!env)
+        JniError error = checkCall(env, false);
+        if(error != JniError::None)
         {
-            throw JniException("no environment found");
+            return JniResult<Return>(error);
         }
- 
-        jclass classId = getClass();
-        if(!classId)
+        jfieldID fieldId = getFieldId(env, name, signature, false);
+        if(!fieldId)
         {
-            throw JniException("no class found");
+            env->ExceptionClear();
+            return JniResult<Return>(JniError::NoField);
         }
- 
-        jfieldID fieldId = env->GetFieldID(classId, name.c_str(), signature.c_str());
-        checkJniException();
-        Return result = getJavaField<Return>(env, classId, fieldId);
-        checkJniException();        
-        return result;
+        Return result;
+        if(!getUncheckedJavaField(env, getInstance(), fieldId, result))
+        {
+            return JniResult<Return>(JniError::JavaException, takeJniException(env));
+        }
+        return JniResult<Return>(result);
     }
- 
+
+    /**
+     * Clear the pending java exception and return it
+     */
+    static JniObject takeJniException(JNIEnv* env);
+
     /**
      * Return the signature for the object
      */
     std::string getSignature() const;
 
+    /**
+     * Return the signature for a class path
+     */
+    static std::string getClassSignature(const std::string& classPath);
+
     /**
      * create an java array of the given type
      */
@@ -538,14 +2612,153 @@ public:
             return false;
         }
         jsize arraySize = env->GetArrayLength(arr);
+        JniLocalFrame frame(env, JniLocalFrame::DefaultChunk, !JniIsLocalRef<Type>::value);
         for(size_t i=0; i<arraySize; i++)
         {
             typename Type::value_type elm;
             convertFromJavaArrayElement(env, arr, i, elm);
             container.insert(container.end(), elm);
+            frame.step();
+        }
+        return true;
+    }
+ 
+    template<typename Type, size_t Size>
+    static typename std::enable_if<!JniIsPrimitive<Type>::value, bool>::type
+    convertFromJavaArray(JNIEnv* env, jarray arr, std::array<Type, Size>& container)
+    {
+        if(!arr)
+        {
+            return false;
+        }
+        size_t arraySize = std::min<size_t>(env->GetArrayLength(arr), Size);
+        JniLocalFrame frame(env, JniLocalFrame::DefaultChunk, !JniIsLocalRef<Type>::value);
+        for(size_t i=0; i<arraySize; i++)
+        {
+            convertFromJavaArrayElement(env, arr, i, container[i]);
+            frame.step();
+        }
+        return true;
+    }
+
+    // template specialization for containers of primitives
+    // will copy all the elements with one jni call
+    template<typename Type>
+    static typename std::enable_if<JniPrimitiveArray<Type>::direct, bool>::type
+    convertFromJavaArray(JNIEnv* env, jarray arr, std::vector<Type>& container)
+    {
+        if(!arr)
+        {
+            return false;
+        }
+        jsize arraySize = env->GetArrayLength(arr);
+        size_t offset = container.size();
+        container.resize(offset+arraySize);
+        if(arraySize > 0)
+        {
+            JniPrimitiveArray<Type>::getRegion(env, arr, 0, arraySize,
+                reinterpret_cast<typename JniPrimitiveArray<Type>::type*>(&container[offset]));
+        }
+        return true;
+    }
+
+    template<typename Type>
+    static typename std::enable_if<!JniPrimitiveArray<Type>::direct, bool>::type
+    convertFromJavaArray(JNIEnv* env, jarray arr, std::vector<Type>& container)
+    {
+        std::vector<typename JniPrimitiveArray<Type>::type> buffer;
+        if(!getPrimitiveArrayRegion<Type>(env, arr, buffer))
+        {
+            return false;
+        }
+        container.insert(container.end(), buffer.begin(), buffer.end());
+        return true;
+    }
+
+    template<typename Type>
+    static typename std::enable_if<JniIsPrimitive<Type>::value, bool>::type
+    convertFromJavaArray(JNIEnv* env, jarray arr, std::list<Type>& container)
+    {
+        std::vector<typename JniPrimitiveArray<Type>::type> buffer;
+        if(!getPrimitiveArrayRegion<Type>(env, arr, buffer))
+        {
+            return false;
+        }
+        container.insert(container.end(), buffer.begin(), buffer.end());
+        return true;
+    }
+
+    template<typename Type>
+    static typename std::enable_if<JniIsPrimitive<Type>::value, bool>::type
+    convertFromJavaArray(JNIEnv* env, jarray arr, std::set<Type>& container)
+    {
+        std::vector<typename JniPrimitiveArray<Type>::type> buffer;
+        if(!getPrimitiveArrayRegion<Type>(env, arr, buffer))
+        {
+            return false;
+        }
+        container.insert(buffer.begin(), buffer.end());
+        return true;
+    }
+
+    template<typename Type, size_t Size>
+    static typename std::enable_if<JniPrimitiveArray<Type>::direct, bool>::type
+    convertFromJavaArray(JNIEnv* env, jarray arr, std::array<Type, Size>& container)
+    {
+        if(!arr)
+        {
+            return false;
+        }
+        jsize arraySize = std::min<jsize>(env->GetArrayLength(arr), Size);
+        if(arraySize > 0)
+        {
+            JniPrimitiveArray<Type>::getRegion(env, arr, 0, arraySize,
+                reinterpret_cast<typename JniPrimitiveArray<Type>::type*>(container.data()));
+        }
+        return true;
+    }
+
+    template<typename Type, size_t Size>
+    static typename std::enable_if<JniIsPrimitive<Type>::value && !JniPrimitiveArray<Type>::direct, bool>::type
+    convertFromJavaArray(JNIEnv* env, jarray arr, std::array<Type, Size>& container)
+    {
+        std::vector<typename JniPrimitiveArray<Type>::type> buffer;
+        if(!getPrimitiveArrayRegion<Type>(env, arr, buffer))
+        {
+            return false;
         }
+        std::copy(buffer.begin(), buffer.begin()+std::min<size_t>(buffer.size(), Size), container.begin());
         return true;
     }
+
+    /**
+     * Copy a whole java primitive array into a jni typed buffer
+     */
+    template<typename Type>
+    static bool getPrimitiveArrayRegion(JNIEnv* env, jarray arr, std::vector<typename JniPrimitiveArray<Type>::type>& buffer)
+    {
+        if(!arr)
+        {
+            return false;
+        }
+        jsize arraySize = env->GetArrayLength(arr);
+        buffer.resize(arraySize);
+        if(arraySize > 0)
+        {
+            JniPrimitiveArray<Type>::getRegion(env, arr, 0, arraySize, buffer.data());
+        }
+        return true;
+    }
+ 
+    /**
+     * Access the elements of a java primitive array without copying them
+     * see JniArrayElements
+     */
+    template<typename Type>
+    static JniArrayElements<Type> accessJavaArray(jarray arr, JniArrayAccess access=JniArrayAccess::ReadOnly)
+    {
+        return JniArrayElements<Type>(getEnvironment(), arr, access);
+    }
  
     template<typename Type>
     static bool convertFromJavaArray(jarray arr, Type& container)
@@ -593,53 +2806,87 @@ public:
     * Set all elements of a java array
     */
     template<typename Type>
-    static void setJavaArrayElements(JNIEnv* env, jarray arr, const Type& obj);
- 
-    template<typename Type>
-    static bool convertFromJavaCollection(JNIEnv* env, jobject obj, Type& out)
+    static void setJavaArrayElements(JNIEnv* env, jarray arr, const Type& obj)
     {
-        if(!obj)
-        {
-            return false;
-        }
-        try
-        {
-            JniObject jcontainer(obj);
-            if(!jcontainer.isInstanceOf("java.util.Collection"))
-            {
-                return false;
-            }
-            out = jcontainer.call<Type>("toArray", out, out);
-            return true;            
-        }
-        catch(JniException)
+        size_t i = 0;
+        JniLocalFrame frame(env);
+        for(typename Type::const_iterator itr = obj.begin(); itr != obj.end(); ++itr)
         {
-            return false;
+            setJavaArrayElement(env, arr, i, *itr);
+            i++;
+            frame.step();
         }
     }
- 
-    template<typename Key, typename Value>
-    static bool convertFromJavaMap(JNIEnv* env, jobject obj, std::map<Key, Value>& out)
+
+    // template specialization for containers of primitives
+    // will copy all the elements with one jni call
+    template<typename Type>
+    static typename std::enable_if<JniPrimitiveArray<Type>::direct>::type
+    setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<Type>& obj)
     {
-        if(!obj)
-        {
-            return false;
-        }
-        JniObject jmap(obj);
-        if(!jmap.isInstanceOf("java.util.Map"))
-        {
-            return false;
-        }
-        JniObject jkeys = jmap.call<JniObject>("keySet", JniObject("java.util.Set"));
-        std::vector<Key> keys = jkeys.callSigned<std::vector<Key>>("toArray", "()[Ljava/lang/Object;", std::vector<Key>());
-        for(typename std::vector<Key>::const_iterator itr = keys.begin(); itr != keys.end(); ++itr)
+        JniPrimitiveArray<Type>::setRegion(env, arr, 0, obj.size(),
+            reinterpret_cast<const typename JniPrimitiveArray<Type>::type*>(obj.data()));
+    }
+
+    template<typename Type>
+    static typename std::enable_if<JniIsPrimitive<Type>::value && !JniPrimitiveArray<Type>::direct>::type
+    setJavaArrayElements(JNIEnv* env, jarray arr, const std::vector<Type>& obj)
+    {
+        setPrimitiveArrayRegion<Type>(env, arr, obj);
+    }
+
+    template<typename Type, size_t Size>
+    static typename std::enable_if<JniPrimitiveArray<Type>::direct>::type
+    setJavaArrayElements(JNIEnv* env, jarray arr, const std::array<Type, Size>& obj)
+    {
+        JniPrimitiveArray<Type>::setRegion(env, arr, 0, Size,
+            reinterpret_cast<const typename JniPrimitiveArray<Type>::type*>(obj.data()));
+    }
+
+    template<typename Type, size_t Size>
+    static typename std::enable_if<JniIsPrimitive<Type>::value && !JniPrimitiveArray<Type>::direct>::type
+    setJavaArrayElements(JNIEnv* env, jarray arr, const std::array<Type, Size>& obj)
+    {
+        setPrimitiveArrayRegion<Type>(env, arr, obj);
+    }
+
+    template<typename Type>
+    static typename std::enable_if<JniIsPrimitive<Type>::value>::type
+    setJavaArrayElements(JNIEnv* env, jarray arr, const std::set<Type>& obj)
+    {
+        setPrimitiveArrayRegion<Type>(env, arr, obj);
+    }
+
+    template<typename Type>
+    static typename std::enable_if<JniIsPrimitive<Type>::value>::type
+    setJavaArrayElements(JNIEnv* env, jarray arr, const std::list<Type>& obj)
+    {
+        setPrimitiveArrayRegion<Type>(env, arr, obj);
+    }
+
+    /**
+     * Copy a primitive container into a java array through a jni typed buffer
+     */
+    template<typename Type, typename Container>
+    static void setPrimitiveArrayRegion(JNIEnv* env, jarray arr, const Container& obj)
+    {
+        std::vector<typename JniPrimitiveArray<Type>::type> buffer(obj.begin(), obj.end());
+        if(!buffer.empty())
         {
-            Value v = jmap.callSigned<Value>("get", "(Ljava/lang/Object;)Ljava/lang/Object;", Value(), *itr);
-            out[*itr] = v;
+            JniPrimitiveArray<Type>::setRegion(env, arr, 0, buffer.size(), buffer.data());
         }
-        return true;
     }
  
+    /**
+     * Convert a java collection or map to a container
+     * defined after JniLocalObject
+     */
+    template<typename Type>
+    static bool convertFromJavaCollection(JNIEnv* env, jobject obj, Type& out);
+ 
+    template<typename Key, typename Value>
+    static bool convertFromJavaMap(JNIEnv* env, jobject obj, std::map<Key, Value>& out);
+ 
     template<typename Key, typename Value>
     static bool convertToMapFromJavaArray(JNIEnv* env, jarray arr, std::map<Key, Value>& out)
     {
@@ -648,6 +2895,7 @@ public:
             return false;
         }
         jsize mapSize = env->GetArrayLength(arr) / 2;
+        JniLocalFrame frame(env, JniLocalFrame::DefaultChunk, !JniIsLocalRef<std::map<Key, Value>>::value);
         for(size_t i=0; i<mapSize; ++i)
         {
             Key k;
@@ -659,6 +2907,7 @@ public:
                     out[k] = v;
                 }
             }
+            frame.step();
         }
         return true;
     }
@@ -696,7 +2945,7 @@ public:
         }
         return false;
     }
-    template<typename Type, int Size>
+    template<typename Type, size_t Size>
     static bool convertFromJavaObject(JNIEnv* env, jobject obj, std::array<Type, Size>& out)
     {
         if(convertFromJavaCollection(env, obj, out))
@@ -763,56 +3012,174 @@ public:
     }
  
     /**
-     * Convert a c++ list container to a jarray
+     * Convert a c++ list container to a jarray
+     */
+    template<typename Type>
+    static jarray createJavaArray(const Type& obj)
+    {
+        JNIEnv* env = getEnvironment();
+        if (!env)
+        {
+            return nullptr;
+        }
+        jarray arr = nullptr;
+        if(obj.empty())
+        {
+            arr = createJavaArray(env, typename Type::value_type(), 0);
+        }
+        else
+        {
+            arr = createJavaArray(env, *obj.begin(), obj.size());
+        }
+        setJavaArrayElements(env, arr, obj);
+        return arr;
+    }
+ 
+    template<typename Key, typename Value>
+    static JniObject createJavaMap(const std::map<Key, Value>& obj, const std::string& classPath="java/util/HashMap")
+    {
+        // presized so the map is not rehashed while filling it
+        JniObject jmap(JniObject::createNewWithCapacity(classPath, (jint)(obj.size()*4/3+1)));
+        JNIEnv* env = getEnvironment();
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        if(!jmap.getClass())
+        {
+            throw JniException("no class found");
+        }
+        if(!jmap.getInstance())
+        {
+            throw JniException("no object found");
+        }
+        jmethodID methodId = jmap.getMethodId(env, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;", false);
+        if(!methodId)
+        {
+            checkJniException(env);
+            throw JniException("no method found");
+        }
+        JniLocalFrame frame(env);
+        for(typename std::map<Key, Value>::const_iterator itr = obj.begin(); itr != obj.end(); ++itr)
+        {
+            jvalue jargs[2];
+            jargs[0].l = convertToJavaObject(env, itr->first);
+            jargs[1].l = convertToJavaObject(env, itr->second);
+            env->CallObjectMethodA(jmap.getInstance(), methodId, jargs);
+            checkJniException(env);
+            frame.step();
+        }
+        return jmap;
+    }
+ 
+    /**
+     * Copy the elements of a container to an Object[]
+     * Every element is boxed or converted and set with its own jni calls
+     */
+    template<typename Type>
+    static jobjectArray createElementBoxedArray(JNIEnv* env, const Type& obj)
+    {
+        jobjectArray arr = env->NewObjectArray((jsize)obj.size(), resolveClass("java/lang/Object"), nullptr);
+        checkJniException(env);
+        JniLocalFrame frame(env);
+        jsize i = 0;
+        for(typename Type::const_iterator itr = obj.begin(); itr != obj.end(); ++itr)
+        {
+            env->SetObjectArrayElement(arr, i++, convertToJavaObject(env, *itr));
+            frame.step();
+        }
+        return arr;
+    }
+
+    template<typename Type>
+    static typename std::enable_if<!JniHasBoxedStream<typename Type::value_type>::value, jobjectArray>::type
+    createBoxedArray(JNIEnv* env, const Type& obj)
+    {
+        return createElementBoxedArray(env, obj);
+    }
+
+    /**
+     * int, long and double containers are copied to a primitive array in bulk
+     * and boxed by a java stream, the calls do not grow with the size.
+     * Without streams they are boxed one by one
+     */
+    template<typename Type>
+    static typename std::enable_if<JniHasBoxedStream<typename Type::value_type>::value, jobjectArray>::type
+    createBoxedArray(JNIEnv* env, const Type& obj)
+    {
+        typedef JniBoxedStream<typename JniPrimitiveArray<typename Type::value_type>::type> Stream;
+        jclass streamClass = Jni::get().getClass(Stream::classPath());
+        if(!streamClass)
+        {
+            return createElementBoxedArray(env, obj);
+        }
+        jarray primitives = createJavaArray(obj);
+        checkJniException(env);
+        jobjectArray arr = createStreamBoxedArray(env, primitives, streamClass, Stream::streamSignature());
+        env->DeleteLocalRef(primitives);
+        return arr;
+    }
+
+    /**
+     * Box a primitive array with Arrays.stream(array).boxed().toArray()
+     */
+    static jobjectArray createStreamBoxedArray(JNIEnv* env, jarray arr, jclass streamClass, const char* streamSignature);
+
+    /**
+     * Create a presized java collection
+     * The elements are copied to an Object[] and added with a single addAll call
      */
     template<typename Type>
-    static jarray createJavaArray(const Type& obj)
+    static JniObject createJavaCollection(const Type& obj, const std::string& classPath, jint capacity)
     {
+        JniObject jcollection(JniObject::createNewWithCapacity(classPath, capacity));
         JNIEnv* env = getEnvironment();
-        if (!env)
-        {
-            return nullptr;
-        }
-        jarray arr = nullptr;
-        if(obj.empty())
-        {
-            arr = createJavaArray(env, typename Type::value_type(), 0);
-        }
-        else
+        if(!env || obj.empty() || !jcollection)
         {
-            arr = createJavaArray(env, *obj.begin(), obj.size());
+            return jcollection;
         }
-        setJavaArrayElements(env, arr, obj);
-        return arr;
-    }
- 
-    template<typename Key, typename Value>
-    static JniObject createJavaMap(const std::map<Key, Value>& obj, const std::string& classPath="java/util/HashMap")
-    {
-        JniObject jmap(JniObject::createNew(classPath));
-        for(typename std::map<Key, Value>::const_iterator itr = obj.begin(); itr != obj.end(); ++itr)
+        jclass arraysClass = resolveClass("java/util/Arrays");
+        jmethodID asList = resolveMethod(arraysClass, "asList", "([Ljava/lang/Object;)Ljava/util/List;", true);
+        jmethodID addAll = resolveMethod(getCollectionClass(), "addAll", "(Ljava/util/Collection;)Z", false);
+        jobjectArray arr = createBoxedArray(env, obj);
+        jvalue jarg;
+        jarg.l = arr;
+        jobject list = env->CallStaticObjectMethodA(arraysClass, asList, &jarg);
+        env->DeleteLocalRef(arr);
+        checkJniException(env);
+        if(list)
         {
-        	Value v = jmap.callSigned("put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;", Value(), itr->first, itr->second);
+            jarg.l = list;
+            env->CallBooleanMethodA(jcollection.getInstance(), addAll, &jarg);
+            env->DeleteLocalRef(list);
+            checkJniException(env);
         }
-        return jmap;
+        return jcollection;
     }
- 
+
     template<typename Type>
     static JniObject createJavaList(const Type& obj, const std::string& classPath="java/util/ArrayList")
     {
-        JniObject jlist(JniObject::createNew(classPath));
-        for(typename Type::const_iterator itr = obj.begin(); itr != obj.end(); ++itr)
-        {
-            jlist.callSignedVoid("add", "(Ljava/lang/Object;)Z", *itr);
-        }
-        return jlist;
+        return createJavaCollection(obj, classPath, (jint)obj.size());
     }
  
     template<typename Type>
     static JniObject createJavaSet(const Type& obj, const std::string& classPath="java/util/HashSet")
     {
-        return createJavaList(obj, classPath);
+        return createJavaCollection(obj, classPath, (jint)(obj.size()*4/3+1));
     }
+
+    /**
+     * Create a java string from standard utf-8
+     * Unlike NewStringUTF this keeps supplementary characters and NULs
+     * Returns a new local ref
+     */
+    static jstring createJavaString(JNIEnv* env, const std::string& str);
+
+    /**
+     * Convert a java string to standard utf-8
+     */
+    static bool convertFromJavaString(JNIEnv* env, jstring str, std::string& out);
  
     /**
      * Convert a c++ type to the jvalue representation
@@ -822,11 +3189,71 @@ public:
     static jvalue convertToJavaValue(const Type& obj);
  
     // template specialization for pointers
+    // java references are objects, other pointers are passed as longs
     template<typename Type>
-    static jvalue convertToJavaValue(Type* obj)
+    static typename std::enable_if<!std::is_convertible<Type*, jobject>::value, jvalue>::type
+    convertToJavaValue(Type* obj)
     {
         return convertToJavaValue((jlong)obj);
     }
+
+    template<typename Type>
+    static typename std::enable_if<std::is_convertible<Type*, jobject>::value, jvalue>::type
+    convertToJavaValue(Type* obj)
+    {
+        jvalue val;
+        val.l = obj;
+        return val;
+    }
+
+    /**
+     * Box a primitive into its java wrapper object
+     * Returns a new local ref, the wrapper methods are only resolved once
+     */
+    template<typename Type>
+    static jobject boxJavaValue(JNIEnv* env, const Type& value)
+    {
+        const BoxedMethods& methods = getBoxedMethods<Type>();
+        jvalue arg = convertToJavaValue(value);
+        jobject obj = env->CallStaticObjectMethodA(methods.classId, methods.valueOf, &arg);
+        checkJniException(env);
+        return obj;
+    }
+
+    /**
+     * Unbox a java wrapper object into a primitive
+     */
+    template<typename Type>
+    static bool unboxJavaValue(JNIEnv* env, jobject obj, Type& out)
+    {
+        if(!obj)
+        {
+            return false;
+        }
+        const BoxedMethods& methods = getBoxedMethods<Type>();
+        out = JniBoxed<Type>::unbox(env, obj, methods.value);
+        checkJniException(env);
+        return true;
+    }
+
+    /**
+     * Convert a c++ type to a java object where java expects an Object
+     * Primitives are boxed. New local refs are not deleted, so call it
+     * inside a JniLocalFrame.
+     */
+    template<typename Type>
+    static typename std::enable_if<JniIsBoxed<Type>::value, jobject>::type
+    convertToJavaObject(JNIEnv* env, const Type& obj)
+    {
+        return boxJavaValue(env, obj);
+    }
+
+    template<typename Type>
+    static typename std::enable_if<!JniIsBoxed<Type>::value, jobject>::type
+    convertToJavaObject(JNIEnv* env, const Type& obj)
+    {
+        return convertToJavaValue(obj).l;
+    }
  
     // template specialization for containers
     template<typename Type>
@@ -839,7 +3266,7 @@ public:
     {
         return convertToJavaValue(createJavaArray(obj));
     }
-    template<typename Type, int Size>
+    template<typename Type, size_t Size>
     static jvalue convertToJavaValue(const std::array<Type, Size>& obj)
     {
         return convertToJavaValue(createJavaArray(obj));
@@ -861,44 +3288,9 @@ public:
      * to decide if we need to delete a local ref
      */
     template<typename Type>
-    static bool isObjectArgument(const Type& obj);
-
-    // template specialization for pointers
-    template<typename Type>
-    static bool isObjectArgument(Type* obj)
-    {
-        return false;
-    }
-
-    // template specialization for containers
-    template<typename Type>
-    static bool isObjectArgument(const std::vector<Type>& obj)
-    {
-        return true;
-    }
-
-    template<typename Type>
-    static bool isObjectArgument(const std::set<Type>& obj)
-    {
-        return true;
-    }
-
-    template<typename Type, int Size>
-    static bool isObjectArgument(const std::array<Type, Size>& obj)
-    {
-        return true;
-    }
-
-    template<typename Type>
-    static bool isObjectArgument(const std::list<Type>& obj)
+    static bool isObjectArgument(const Type& obj)
     {
-        return true;
-    }
-
-    template<typename Key, typename Value>
-    static bool isObjectArgument(const std::map<Key, Value>& obj)
-    {
-        return true;
+        return JniIsObjectArgument<Type>::value;
     }
  
     /**
@@ -923,6 +3315,36 @@ public:
     * Returns the jobject reference. This is a new local ref
     */
     jobject getNewLocalInstance() const;
+
+    /**
+     * Returns the memory of a direct java.nio.ByteBuffer without copying it
+     * The view covers the bytes between the position and the limit
+     * The view is empty if the object is not a direct ByteBuffer,
+     * other buffer types like IntBuffer are not supported
+     * Throws a JniException if the position is not aligned for the type
+     * It is only valid while the buffer object is referenced
+     */
+    template<typename Type>
+    JniSpan<Type> getDirectBuffer() const
+    {
+        size_t size = 0;
+        void* data = getDirectBufferBytes(size);
+        if(!data)
+        {
+            return JniSpan<Type>();
+        }
+        if(reinterpret_cast<std::uintptr_t>(data) % alignof(Type) != 0)
+        {
+            throw JniException("direct buffer position is not aligned");
+        }
+        return JniSpan<Type>(static_cast<Type*>(data), size/sizeof(Type));
+    }
+
+    /**
+     * Returns the address and the size in bytes of a direct ByteBuffer
+     * between its position and limit, null if it is not one
+     */
+    void* getDirectBufferBytes(size_t& size) const;
  
     /**
      * Return true if class path and class ref match
@@ -943,11 +3365,298 @@ public:
      * Copy a jni object
      */
     JniObject& operator=(const JniObject& other);
+
+    /**
+     * Move a jni object, the references are transferred
+     */
+    JniObject& operator=(JniObject&& other);
  
     /**
      * Compare two jni objects
      */
     bool operator==(const JniObject& other) const;
 };
+
+/**
+ * A jni object that holds local references
+ * It is cheaper to create than a JniObject but it is only valid
+ * in the current native frame and thread.
+ * Copying it into a JniObject promotes it to global references.
+ */
+class JniLocalObject : public JniObject
+{
+public:
+    JniLocalObject(const std::string& classPath, jobject javaObj=nullptr, jclass classId=nullptr);
+    JniLocalObject(jclass classId, jobject javaObj);
+    JniLocalObject(jobject javaObj=nullptr);
+    JniLocalObject(const JniObject& other);
+    JniLocalObject(const JniLocalObject& other);
+};
+
+template<typename Type>
+bool JniObject::convertFromJavaCollection(JNIEnv* env, jobject obj, Type& out)
+{
+    if(!obj)
+    {
+        return false;
+    }
+    jclass collectionClass = getCollectionClass();
+    if(!collectionClass || !env->IsInstanceOf(obj, collectionClass))
+    {
+        return false;
+    }
+    JniLocalObject jcontainer(obj);
+    JniResult<Type> result = jcontainer.tryCall<Type>("toArray", out, out);
+    if(!result)
+    {
+        return false;
+    }
+    out = result.getValue();
+    return true;
+}
+
+template<typename Key, typename Value>
+bool JniObject::convertFromJavaMap(JNIEnv* env, jobject obj, std::map<Key, Value>& out)
+{
+    if(!obj)
+    {
+        return false;
+    }
+    jclass mapClass = getMapClass();
+    jclass collectionClass = getCollectionClass();
+    if(!mapClass || !collectionClass || !env->IsInstanceOf(obj, mapClass))
+    {
+        return false;
+    }
+    // keys and values are read in bulk as two parallel arrays, both views
+    // iterate the entries in the same order while the map does not change
+    jmethodID keySet = resolveMethod(mapClass, "keySet", "()Ljava/util/Set;", false);
+    jmethodID values = resolveMethod(mapClass, "values", "()Ljava/util/Collection;", false);
+    jmethodID toArray = resolveMethod(collectionClass, "toArray", "()[Ljava/lang/Object;", false);
+    jobjectArray jkeys = nullptr;
+    jobjectArray jvalues = nullptr;
+    {
+        jobject keys = env->CallObjectMethodA(obj, keySet, nullptr);
+        checkJniException(env);
+        if(keys)
+        {
+            jkeys = (jobjectArray)env->CallObjectMethodA(keys, toArray, nullptr);
+            env->DeleteLocalRef(keys);
+            checkJniException(env);
+        }
+    }
+    {
+        jobject vals = env->CallObjectMethodA(obj, values, nullptr);
+        if(env->ExceptionCheck())
+        {
+            env->DeleteLocalRef(jkeys);
+            checkJniException(env);
+        }
+        if(vals)
+        {
+            jvalues = (jobjectArray)env->CallObjectMethodA(vals, toArray, nullptr);
+            env->DeleteLocalRef(vals);
+            if(env->ExceptionCheck())
+            {
+                env->DeleteLocalRef(jkeys);
+                checkJniException(env);
+            }
+        }
+    }
+    bool result = false;
+    jsize size = jkeys ? env->GetArrayLength(jkeys) : 0;
+    if(jkeys && jvalues && env->GetArrayLength(jvalues) == size)
+    {
+        JniLocalFrame frame(env, JniLocalFrame::DefaultChunk, !JniIsLocalRef<std::map<Key, Value>>::value);
+        for(jsize i=0; i<size; ++i)
+        {
+            Key k;
+            if(convertFromJavaObject(env, env->GetObjectArrayElement(jkeys, i), k))
+            {
+                Value v;
+                if(convertFromJavaObject(env, env->GetObjectArrayElement(jvalues, i), v))
+                {
+                    out[k] = v;
+                }
+            }
+            frame.step();
+        }
+        result = true;
+    }
+    env->DeleteLocalRef(jkeys);
+    env->DeleteLocalRef(jvalues);
+    return result;
+}
+
+template<>
+void JniObject::callCheckedJavaMethod<void>(JNIEnv* env, jobject objId, jmethodID methodId, jvalue* args);
+
+template<>
+void JniObject::callCheckedStaticJavaMethod<void>(JNIEnv* env, jclass classId, jmethodID methodId, jvalue* args);
+
+/**
+ * The jni arguments of a call
+ * the local refs created for them are deleted when it goes out of scope
+ */
+template<typename... Args>
+class JniArguments
+{
+private:
+    JNIEnv* _env;
+    std::array<jvalue, sizeof...(Args)> _values;
+
+    JniArguments(const JniArguments& other) = delete;
+    JniArguments& operator=(const JniArguments& other) = delete;
+public:
+    JniArguments(JNIEnv* env, const Args&... args):
+    _env(env), _values{{JniObject::convertToJavaValue(args)...}}
+    {
+    }
+
+    ~JniArguments()
+    {
+        static const bool objects[] = {false, JniIsObjectArgument<Args>::value...};
+        for(size_t i=0; i<_values.size(); ++i)
+        {
+            if(objects[i+1])
+            {
+                _env->DeleteLocalRef(_values[i].l);
+            }
+        }
+    }
+
+    jvalue* data()
+    {
+        return _values.data();
+    }
+};
+
+/**
+ * An object method that is resolved once
+ * Calling it does not build signatures or look up anything
+ * The signature is deduced from the types unless it is passed
+ */
+template<typename Return, typename... Args>
+class JniMethod<Return(Args...)>
+{
+private:
+    jmethodID _method;
+public:
+    JniMethod(const std::string& classPath, const std::string& name):
+    JniMethod(classPath, name, JniSignature<Return, Args...>::type::value)
+    {
+    }
+
+    JniMethod(const std::string& classPath, const std::string& name, const std::string& signature):
+    _method(JniObject::resolveMethod(JniObject::resolveClass(classPath), name, signature, false))
+    {
+    }
+
+    Return call(const JniObject& obj, const Args&... args) const
+    {
+        JNIEnv* env = JniObject::getEnvironment();
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        jobject objId = obj.getInstance();
+        if(!objId)
+        {
+            throw JniException("no object found");
+        }
+        JniArguments<Args...> jargs(env, args...);
+        return JniObject::callCheckedJavaMethod<Return>(env, objId, _method, jargs.data());
+    }
+
+    Return operator()(const JniObject& obj, const Args&... args) const
+    {
+        return call(obj, args...);
+    }
+};
+
+/**
+ * A class method that is resolved once
+ */
+template<typename Return, typename... Args>
+class JniStaticMethod<Return(Args...)>
+{
+private:
+    jclass _class;
+    jmethodID _method;
+public:
+    JniStaticMethod(const std::string& classPath, const std::string& name):
+    JniStaticMethod(classPath, name, JniSignature<Return, Args...>::type::value)
+    {
+    }
+
+    JniStaticMethod(const std::string& classPath, const std::string& name, const std::string& signature):
+    _class(JniObject::resolveClass(classPath)),
+    _method(JniObject::resolveMethod(_class, name, signature, true))
+    {
+    }
+
+    Return call(const Args&... args) const
+    {
+        JNIEnv* env = JniObject::getEnvironment();
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        JniArguments<Args...> jargs(env, args...);
+        return JniObject::callCheckedStaticJavaMethod<Return>(env, _class, _method, jargs.data());
+    }
+
+    Return operator()(const Args&... args) const
+    {
+        return call(args...);
+    }
+};
+
+/**
+ * A class constructor that is resolved once
+ */
+template<typename... Args>
+class JniConstructor
+{
+private:
+    std::string _classPath;
+    jclass _class;
+    jmethodID _method;
+public:
+    JniConstructor(const std::string& classPath):
+    JniConstructor(classPath, JniSignature<void, Args...>::type::value)
+    {
+    }
+
+    JniConstructor(const std::string& classPath, const std::string& signature):
+    _classPath(classPath),
+    _class(JniObject::resolveClass(classPath)),
+    _method(JniObject::resolveMethod(_class, "<init>", signature, false))
+    {
+    }
+
+    JniObject createNew(const Args&... args) const
+    {
+        JNIEnv* env = JniObject::getEnvironment();
+        if(!env)
+        {
+            throw JniException("no environment found");
+        }
+        jobject obj = nullptr;
+        {
+            JniArguments<Args...> jargs(env, args...);
+            obj = env->NewObjectA(_class, _method, jargs.data());
+        }
+        JniObject::checkJniException();
+        JniObject result(_classPath, obj, _class);
+        env->DeleteLocalRef(obj);
+        return result;
+    }
+
+    JniObject operator()(const Args&... args) const
+    {
+        return createNew(args...);
+    }
+};
  
 #endif